@@ -0,0 +1,33 @@
+QT       += core dbus
+QT       -= gui
+
+TARGET = deepin-menu-client
+TEMPLATE = lib
+VERSION = 1.0.0
+
+CONFIG += c++11 create_pc create_prl no_install_prl
+
+SOURCES += \
+    dmenubuilder.cpp \
+    dmenuclient.cpp
+
+HEADERS += \
+    dmenubuilder.h \
+    dmenuclient.h
+
+isEmpty(PREFIX): PREFIX = /usr
+isEmpty(LIB_INSTALL_DIR): LIB_INSTALL_DIR = $$[QT_INSTALL_LIBS]
+
+target.path = $$LIB_INSTALL_DIR
+
+includes.path = $$PREFIX/include/deepin-menu-client
+includes.files = $$HEADERS
+
+QMAKE_PKGCONFIG_NAME = deepin-menu-client
+QMAKE_PKGCONFIG_DESCRIPTION = Client library for the deepin menu service
+QMAKE_PKGCONFIG_INCDIR = $$includes.path
+QMAKE_PKGCONFIG_LIBDIR = $$target.path
+QMAKE_PKGCONFIG_DESTDIR = pkgconfig
+QMAKE_PKGCONFIG_REQUIRES = Qt5Core Qt5DBus
+
+INSTALLS += target includes
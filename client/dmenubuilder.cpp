@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+
+#include "dmenubuilder.h"
+
+DMenuBuilder::DMenuBuilder()
+    : m_menus(1)
+{
+
+}
+
+DMenuBuilder &DMenuBuilder::addItem(const QString &id, const QString &text, bool active)
+{
+    QJsonObject item;
+    item["itemId"] = id;
+    item["itemText"] = text;
+    item["isActive"] = active;
+    item["isCheckable"] = false;
+    item["checked"] = false;
+
+    appendItem(item);
+
+    return *this;
+}
+
+DMenuBuilder &DMenuBuilder::addCheckableItem(const QString &id, const QString &text, bool checked, bool active)
+{
+    addItem(id, text, active);
+    lastItem()["isCheckable"] = true;
+    lastItem()["checked"] = checked;
+
+    return *this;
+}
+
+DMenuBuilder &DMenuBuilder::addCheckboxItem(const QString &group, const QString &name, const QString &text, bool checked)
+{
+    return addCheckableItem(QString("%1:checkbox:%2").arg(group, name), text, checked);
+}
+
+DMenuBuilder &DMenuBuilder::addRadioItem(const QString &group, const QString &name, const QString &text, bool checked)
+{
+    return addCheckableItem(QString("%1:radio:%2").arg(group, name), text, checked);
+}
+
+DMenuBuilder &DMenuBuilder::addSeparator()
+{
+    // the menu service treats items without text as separators.
+    return addItem(QString(), QString(), false);
+}
+
+DMenuBuilder &DMenuBuilder::setItemIcon(const QString &icon, const QString &hoverIcon, const QString &inactiveIcon)
+{
+    QJsonObject &item = lastItem();
+    item["itemIcon"] = icon;
+    item["itemIconHover"] = hoverIcon.isEmpty() ? icon : hoverIcon;
+    item["itemIconInactive"] = inactiveIcon.isEmpty() ? icon : inactiveIcon;
+
+    return *this;
+}
+
+DMenuBuilder &DMenuBuilder::setItemExtra(const QString &extra)
+{
+    lastItem()["itemExtra"] = extra;
+
+    return *this;
+}
+
+DMenuBuilder &DMenuBuilder::beginSubMenu(const QString &id, const QString &text, bool active)
+{
+    addItem(id, text, active);
+    m_menus.append(QVector<QJsonObject>());
+
+    return *this;
+}
+
+DMenuBuilder &DMenuBuilder::endSubMenu()
+{
+    Q_ASSERT_X(m_menus.size() > 1, Q_FUNC_INFO, "endSubMenu() without beginSubMenu()");
+    if (m_menus.size() < 2)
+        return *this;
+
+    const QJsonObject subMenu = menuObject(m_menus.takeLast());
+    lastItem()["itemSubMenu"] = subMenu;
+
+    return *this;
+}
+
+bool DMenuBuilder::isEmpty() const
+{
+    return m_menus.first().isEmpty();
+}
+
+/**
+ * @brief DMenuBuilder::toJson
+ * @return the root menu, submenus which are still open are closed as if
+ * endSubMenu() was called for them.
+ */
+QJsonObject DMenuBuilder::toJson() const
+{
+    QVector<QVector<QJsonObject>> menus = m_menus;
+    while (menus.size() > 1) {
+        const QJsonObject subMenu = menuObject(menus.takeLast());
+        menus.last().last()["itemSubMenu"] = subMenu;
+    }
+
+    return menuObject(menus.first());
+}
+
+QJsonObject &DMenuBuilder::lastItem()
+{
+    // right after beginSubMenu() the submenu is still empty, the item added
+    // last is the one it belongs to.
+    if (m_menus.last().isEmpty() && m_menus.size() > 1)
+        return m_menus[m_menus.size() - 2].last();
+
+    Q_ASSERT_X(!m_menus.last().isEmpty(), Q_FUNC_INFO, "item setter called before any item was added");
+    if (m_menus.last().isEmpty()) {
+        qCritical() << Q_FUNC_INFO << "item setter called before any item was added, ignored";
+
+        m_discardedItem = QJsonObject();
+        return m_discardedItem;
+    }
+
+    return m_menus.last().last();
+}
+
+void DMenuBuilder::appendItem(const QJsonObject &item)
+{
+    m_menus.last().append(item);
+}
+
+QJsonObject DMenuBuilder::menuObject(const QVector<QJsonObject> &items)
+{
+    QJsonArray array;
+    for (const QJsonObject &item : items)
+        array.append(item);
+
+    QJsonObject menu;
+    menu["items"] = array;
+    menu["checkableMenu"] = false;
+    menu["singleCheck"] = false;
+
+    return menu;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DMENUBUILDER_H
+#define DMENUBUILDER_H
+
+#include <QString>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QVector>
+
+/**
+ * @brief DMenuBuilder builds the item tree understood by com.deepin.menu.Menu.
+ *
+ * Items are appended to the current menu, the item setters always apply to
+ * the item added last, which is the submenu's own item right after
+ * beginSubMenu(). Calling them before any item was added is an error.
+ * Submenus still open when toJson() is called are closed by it:
+ *
+ * @code
+ * DMenuBuilder menu;
+ * menu.addItem("open", "Open").setItemIcon("document-open")
+ *     .addSeparator()
+ *     .beginSubMenu("sort", "Sort By")
+ *         .addRadioItem("sort", "name", "Name", true)
+ *         .addRadioItem("sort", "size", "Size")
+ *     .endSubMenu();
+ * @endcode
+ */
+class DMenuBuilder
+{
+public:
+    DMenuBuilder();
+
+    DMenuBuilder &addItem(const QString &id, const QString &text, bool active = true);
+    DMenuBuilder &addCheckableItem(const QString &id, const QString &text, bool checked = false, bool active = true);
+    DMenuBuilder &addCheckboxItem(const QString &group, const QString &name, const QString &text, bool checked = false);
+    DMenuBuilder &addRadioItem(const QString &group, const QString &name, const QString &text, bool checked = false);
+    DMenuBuilder &addSeparator();
+
+    DMenuBuilder &setItemIcon(const QString &icon, const QString &hoverIcon = QString(), const QString &inactiveIcon = QString());
+    DMenuBuilder &setItemExtra(const QString &extra);
+
+    DMenuBuilder &beginSubMenu(const QString &id, const QString &text, bool active = true);
+    DMenuBuilder &endSubMenu();
+
+    bool isEmpty() const;
+    QJsonObject toJson() const;
+
+private:
+    QJsonObject &lastItem();
+    void appendItem(const QJsonObject &item);
+    static QJsonObject menuObject(const QVector<QJsonObject> &items);
+
+    // the innermost menu being built is the last one, every menu but the
+    // root one belongs to the last item of the menu before it.
+    QVector<QVector<QJsonObject>> m_menus;
+    // what item setters called before any item was added write to in
+    // release builds, debug builds assert.
+    QJsonObject m_discardedItem;
+};
+
+#endif // DMENUBUILDER_H
@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QJsonDocument>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusVariant>
+
+#include "dmenuclient.h"
+
+#define MENU_SERVICE_NAME "com.deepin.menu"
+#define MENU_SERVICE_PATH "/com/deepin/menu"
+#define MENU_MANAGER_INTERFACE "com.deepin.menu.Manager"
+#define MENU_INTERFACE "com.deepin.menu.Menu"
+#define PROPERTIES_INTERFACE "org.freedesktop.DBus.Properties"
+
+#define FEATURE_INLINE_MENU_CONTENT "inline-menu-content"
+
+static QString DirectionToString(DMenuClient::ArrowDirection direction)
+{
+    switch (direction) {
+    case DMenuClient::ArrowTop:
+        return "top";
+    case DMenuClient::ArrowLeft:
+        return "left";
+    case DMenuClient::ArrowRight:
+        return "right";
+    default:
+        return "bottom";
+    }
+}
+
+DMenuClient::DMenuClient(QObject *parent)
+    : DMenuClient(QDBusConnection::sessionBus(), parent)
+{
+
+}
+
+DMenuClient::DMenuClient(const QDBusConnection &connection, QObject *parent)
+    : QObject(parent)
+    , m_connection(connection)
+    , m_wireFormat(AutoFormat)
+    , m_inlineSupported(-1)
+    , m_showSerial(0)
+    , m_triggerTime(-1)
+{
+    queryFeatures();
+}
+
+DMenuClient::~DMenuClient()
+{
+    detachMenuObject();
+}
+
+DMenuClient::WireFormat DMenuClient::wireFormat() const
+{
+    return m_wireFormat;
+}
+
+void DMenuClient::setWireFormat(DMenuClient::WireFormat format)
+{
+    m_wireFormat = format;
+}
+
+void DMenuClient::showMenu(const DMenuBuilder &menu, const QPoint &pos, bool isScaled,
+                           ItemInvokedCallback invoked, MenuUnregisteredCallback unregistered)
+{
+    QJsonObject params;
+    params["x"] = pos.x();
+    params["y"] = pos.y();
+    params["isDockMenu"] = false;
+    params["isScaled"] = isScaled;
+    params["menuJsonContent"] = menu.toJson();
+
+    show(params, invoked, unregistered);
+}
+
+void DMenuClient::showDockMenu(const DMenuBuilder &menu, const QPoint &pos, ArrowDirection direction,
+                               ItemInvokedCallback invoked, MenuUnregisteredCallback unregistered)
+{
+    QJsonObject params;
+    params["x"] = pos.x();
+    params["y"] = pos.y();
+    params["isDockMenu"] = true;
+    params["direction"] = DirectionToString(direction);
+    params["menuJsonContent"] = menu.toJson();
+
+    show(params, invoked, unregistered);
+}
+
+void DMenuClient::setTrace(const QString &traceId, qint64 triggerTime)
+{
+    m_traceId = traceId;
+    m_triggerTime = triggerTime;
+}
+
+void DMenuClient::setItemActivity(const QString &itemId, bool isActive)
+{
+    callMenuObject("SetItemActivity", QVariantList() << itemId << isActive);
+}
+
+void DMenuClient::setItemChecked(const QString &itemId, bool checked)
+{
+    callMenuObject("SetItemChecked", QVariantList() << itemId << checked);
+}
+
+void DMenuClient::setItemText(const QString &itemId, const QString &text)
+{
+    callMenuObject("SetItemText", QVariantList() << itemId << text);
+}
+
+QString DMenuClient::menuObjectPath() const
+{
+    return m_menuObjectPath;
+}
+
+void DMenuClient::onFeaturesFinished(QDBusPendingCallWatcher *watcher)
+{
+    watcher->deleteLater();
+
+    // services older than the Features property only speak the legacy format.
+    QDBusPendingReply<QDBusVariant> reply = *watcher;
+    const QStringList features = reply.isError() ? QStringList() : reply.value().variant().toStringList();
+
+    m_inlineSupported = features.contains(FEATURE_INLINE_MENU_CONTENT) ? 1 : 0;
+}
+
+void DMenuClient::onItemInvoked(const QString &itemId, bool checked, const QDBusMessage &message)
+{
+    if (message.service() != m_menuObjectOwner)
+        return;
+
+    if (m_itemInvokedCallback)
+        m_itemInvokedCallback(itemId, checked);
+
+    emit itemInvoked(itemId, checked);
+}
+
+void DMenuClient::onMenuShown(const QString &traceId, const QVariantMap &timings, const QDBusMessage &message)
+{
+    if (message.service() != m_menuObjectOwner)
+        return;
+
+    emit menuTimings(traceId, timings);
+}
+
+void DMenuClient::onMenuUnregistered(const QDBusMessage &message)
+{
+    if (message.service() != m_menuObjectOwner)
+        return;
+
+    MenuUnregisteredCallback callback = m_menuUnregisteredCallback;
+
+    detachMenuObject();
+
+    if (callback)
+        callback();
+
+    emit menuUnregistered();
+}
+
+void DMenuClient::queryFeatures()
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(MENU_SERVICE_NAME, MENU_SERVICE_PATH,
+                                                          PROPERTIES_INTERFACE, "Get");
+    message << MENU_MANAGER_INTERFACE << "Features";
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &DMenuClient::onFeaturesFinished);
+}
+
+void DMenuClient::show(const QJsonObject &params, ItemInvokedCallback invoked, MenuUnregisteredCallback unregistered)
+{
+    const quint64 serial = ++m_showSerial;
+
+    QDBusMessage registerMessage = QDBusMessage::createMethodCall(MENU_SERVICE_NAME, MENU_SERVICE_PATH,
+                                                                  MENU_MANAGER_INTERFACE, "RegisterMenu");
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(registerMessage), this);
+
+    // serialize the menu while the RegisterMenu reply is on its way.
+    QJsonObject request(params);
+    if (!m_traceId.isEmpty()) {
+        request["traceId"] = m_traceId;
+        if (m_triggerTime >= 0)
+            request["triggerTime"] = double(m_triggerTime);
+
+        m_traceId.clear();
+        m_triggerTime = -1;
+    }
+    if (!useInlineFormat()) {
+        const QJsonDocument content(params["menuJsonContent"].toObject());
+        request["menuJsonContent"] = QString::fromUtf8(content.toJson(QJsonDocument::Compact));
+    }
+    const QString requestJson = QString::fromUtf8(QJsonDocument(request).toJson(QJsonDocument::Compact));
+
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] (QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+
+        // a newer show request has replaced this one already.
+        if (serial != m_showSerial)
+            return;
+
+        QDBusPendingReply<QDBusObjectPath> reply = *call;
+        if (reply.isError()) {
+            emit error(reply.error().message());
+            return;
+        }
+
+        const QString path = reply.value().path();
+        attachMenuObject(path, reply.reply().service());
+        m_itemInvokedCallback = invoked;
+        m_menuUnregisteredCallback = unregistered;
+
+        QDBusMessage showMessage = QDBusMessage::createMethodCall(MENU_SERVICE_NAME, path,
+                                                                  MENU_INTERFACE, "ShowMenu");
+        showMessage << requestJson;
+
+        QDBusPendingCallWatcher *showWatcher = new QDBusPendingCallWatcher(m_connection.asyncCall(showMessage), this);
+        connect(showWatcher, &QDBusPendingCallWatcher::finished, this, [=] (QDBusPendingCallWatcher *showCall) {
+            showCall->deleteLater();
+
+            if (showCall->isError())
+                emit error(showCall->error().message());
+            else
+                emit menuShown(path);
+        });
+    });
+}
+
+/**
+ * @brief DMenuClient::attachMenuObject listens to the signals of the menu
+ * object at path.
+ * @param owner the unique name of the service which registered it.
+ *
+ * The match rules leave the sender out on purpose: QtDBus resolves a well
+ * known sender name with a blocking GetNameOwner call, while AddMatch alone
+ * is sent without waiting for its reply. The slots compare the sender with
+ * owner instead.
+ */
+void DMenuClient::attachMenuObject(const QString &path, const QString &owner)
+{
+    detachMenuObject();
+
+    m_menuObjectPath = path;
+    m_menuObjectOwner = owner;
+    m_connection.connect(QString(), path, MENU_INTERFACE, "ItemInvoked",
+                         this, SLOT(onItemInvoked(QString, bool, QDBusMessage)));
+    m_connection.connect(QString(), path, MENU_INTERFACE, "MenuUnregistered",
+                         this, SLOT(onMenuUnregistered(QDBusMessage)));
+    m_connection.connect(QString(), path, MENU_INTERFACE, "MenuShown",
+                         this, SLOT(onMenuShown(QString, QVariantMap, QDBusMessage)));
+}
+
+void DMenuClient::detachMenuObject()
+{
+    if (m_menuObjectPath.isEmpty())
+        return;
+
+    m_connection.disconnect(QString(), m_menuObjectPath, MENU_INTERFACE, "ItemInvoked",
+                            this, SLOT(onItemInvoked(QString, bool, QDBusMessage)));
+    m_connection.disconnect(QString(), m_menuObjectPath, MENU_INTERFACE, "MenuUnregistered",
+                            this, SLOT(onMenuUnregistered(QDBusMessage)));
+    m_connection.disconnect(QString(), m_menuObjectPath, MENU_INTERFACE, "MenuShown",
+                            this, SLOT(onMenuShown(QString, QVariantMap, QDBusMessage)));
+
+    m_menuObjectPath.clear();
+    m_menuObjectOwner.clear();
+    m_itemInvokedCallback = nullptr;
+    m_menuUnregisteredCallback = nullptr;
+}
+
+void DMenuClient::callMenuObject(const QString &method, const QVariantList &arguments)
+{
+    if (m_menuObjectPath.isEmpty())
+        return;
+
+    QDBusMessage message = QDBusMessage::createMethodCall(MENU_SERVICE_NAME, m_menuObjectPath,
+                                                          MENU_INTERFACE, method);
+    message.setArguments(arguments);
+
+    m_connection.asyncCall(message);
+}
+
+bool DMenuClient::useInlineFormat() const
+{
+    switch (m_wireFormat) {
+    case InlineFormat:
+        return true;
+    case LegacyFormat:
+        return false;
+    default:
+        return m_inlineSupported == 1;
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DMENUCLIENT_H
+#define DMENUCLIENT_H
+
+#include <QObject>
+#include <QPoint>
+#include <QString>
+#include <QVariantMap>
+#include <QDBusConnection>
+#include <QDBusMessage>
+
+#include <functional>
+
+#include "dmenubuilder.h"
+
+class QDBusPendingCallWatcher;
+
+/**
+ * @brief DMenuClient shows menus through the deepin-menu service.
+ *
+ * Everything is asynchronous: RegisterMenu and ShowMenu never block the
+ * caller, the results are reported through signals and the optional
+ * callbacks given to showMenu()/showDockMenu(). The wire format is picked
+ * from the features the service announces, see WireFormat.
+ */
+class DMenuClient : public QObject
+{
+    Q_OBJECT
+public:
+    enum ArrowDirection {
+        ArrowTop,
+        ArrowBottom,
+        ArrowLeft,
+        ArrowRight
+    };
+
+    enum WireFormat {
+        // use the best format supported by the running service.
+        AutoFormat,
+        // menu content as a JSON encoded string, understood by every service.
+        LegacyFormat,
+        // menu content as an inline JSON object, parsed only once.
+        InlineFormat
+    };
+
+    typedef std::function<void (const QString &itemId, bool checked)> ItemInvokedCallback;
+    typedef std::function<void ()> MenuUnregisteredCallback;
+
+    explicit DMenuClient(QObject *parent = nullptr);
+    explicit DMenuClient(const QDBusConnection &connection, QObject *parent = nullptr);
+    ~DMenuClient() override;
+
+    WireFormat wireFormat() const;
+    void setWireFormat(WireFormat format);
+
+    void showMenu(const DMenuBuilder &menu, const QPoint &pos, bool isScaled = true,
+                  ItemInvokedCallback invoked = nullptr,
+                  MenuUnregisteredCallback unregistered = nullptr);
+    void showDockMenu(const DMenuBuilder &menu, const QPoint &pos, ArrowDirection direction,
+                      ItemInvokedCallback invoked = nullptr,
+                      MenuUnregisteredCallback unregistered = nullptr);
+
+    // the next menu shown is traced: the service reports its timings with
+    // menuTimings(). triggerTime is the time of the input event which
+    // asked for the menu, e.g. the X event time, in milliseconds.
+    void setTrace(const QString &traceId, qint64 triggerTime = -1);
+
+    void setItemActivity(const QString &itemId, bool isActive);
+    void setItemChecked(const QString &itemId, bool checked);
+    void setItemText(const QString &itemId, const QString &text);
+
+    QString menuObjectPath() const;
+
+signals:
+    void menuShown(const QString &menuObjectPath);
+    void itemInvoked(const QString &itemId, bool checked);
+    void menuUnregistered();
+    void menuTimings(const QString &traceId, const QVariantMap &timings);
+    void error(const QString &message);
+
+private slots:
+    void onFeaturesFinished(QDBusPendingCallWatcher *watcher);
+    void onItemInvoked(const QString &itemId, bool checked, const QDBusMessage &message);
+    void onMenuUnregistered(const QDBusMessage &message);
+    void onMenuShown(const QString &traceId, const QVariantMap &timings, const QDBusMessage &message);
+
+private:
+    void queryFeatures();
+    void show(const QJsonObject &params, ItemInvokedCallback invoked, MenuUnregisteredCallback unregistered);
+    void attachMenuObject(const QString &path, const QString &owner);
+    void detachMenuObject();
+    void callMenuObject(const QString &method, const QVariantList &arguments);
+    bool useInlineFormat() const;
+
+    QDBusConnection m_connection;
+    WireFormat m_wireFormat;
+    // -1 while the features of the service are still unknown.
+    int m_inlineSupported;
+    QString m_menuObjectPath;
+    // unique name of the service the menu object belongs to.
+    QString m_menuObjectOwner;
+    quint64 m_showSerial;
+    QString m_traceId;
+    qint64 m_triggerTime;
+
+    ItemInvokedCallback m_itemInvokedCallback;
+    MenuUnregisteredCallback m_menuUnregisteredCallback;
+};
+
+#endif // DMENUCLIENT_H
@@ -11,6 +11,15 @@
 from PyQt5.QtCore import pyqtSignal
 from PyQt5.QtDBus import QDBusAbstractInterface, QDBusConnection, QDBusReply
 
+_managerInterface = None
+
+def sharedManagerInterface():
+    """Returns the MenuManagerInterface shared by every menu of this process."""
+    global _managerInterface
+    if _managerInterface is None:
+        _managerInterface = MenuManagerInterface()
+    return _managerInterface
+
 class MenuManagerInterface(QDBusAbstractInterface):
 
     def __init__(self):
@@ -23,6 +32,9 @@ class MenuManagerInterface(QDBusAbstractInterface):
     def registerMenu(self):
         return self.call('RegisterMenu')
 
+    def registerMenuAsync(self):
+        return self.asyncCall('RegisterMenu')
+
     def unregisterMenu(self, objPath):
         self.call('UnregisterMenu', objPath)
 
@@ -42,7 +54,7 @@ class MenuObjectInterface(QDBusAbstractInterface):
                                                   None)
 
     def showMenu(self, jsonContent):
-        self.asyncCall('ShowMenu', jsonContent)
+        return self.asyncCall('ShowMenu', jsonContent)
 
     def setItemText(self, id, value):
         self.asyncCall('SetItemText', id, value)
@@ -10,8 +10,23 @@
 
 import json
 from PyQt5.QtCore import QObject, pyqtSlot, pyqtSignal
-from PyQt5.QtDBus import QDBusReply
-from DBusInterfaces import MenuManagerInterface, MenuObjectInterface
+from PyQt5.QtDBus import QDBusPendingCallWatcher, QDBusPendingReply
+from DBusInterfaces import sharedManagerInterface, MenuObjectInterface
+
+# Proxies of the menu objects handed out to menus created with keepWarm=True.
+# The service hands out a small pool of fixed paths, so later shows reuse the
+# proxy of a path instead of building a new one.
+_warmMenuInterfaces = {}
+
+def objectPathString(value):
+    return value.path() if hasattr(value, "path") else str(value)
+
+def menuObjectInterface(path, keepWarm):
+    if not keepWarm:
+        return MenuObjectInterface(path)
+    if path not in _warmMenuInterfaces:
+        _warmMenuInterfaces[path] = MenuObjectInterface(path)
+    return _warmMenuInterfaces[path]
 
 def parseMenuItem(menuItem):
     assert len(menuItem) >= 2
@@ -39,22 +54,54 @@ def validateItemGroupInfo(item, groupId, groupType):
     info = item.id.split(":")
     item.id = "%s:%s:%s" % (groupId, groupType, info[-1])
 
-class MenuItem(QObject):
+EMPTY_MENU_CONTENT = {"items": [], "checkableMenu": False, "singleCheck": False}
+EMPTY_MENU_JSON = json.dumps(EMPTY_MENU_CONTENT)
+
+class MenuItem(object):
+    # changing any of these attributes changes the serialized menu.
+    serializedAttributes = frozenset(("id", "text", "extra", "icons", "isActive",
+                                      "isCheckable", "checked", "showCheckmark"))
+
     def __init__(self, id, text, icons=None, subMenu=None,
                  isActive=True, isCheckable=False, checked=False, showCheckmark=True, extra=""):
-        super(MenuItem, self).__init__()
-        self.id = id
-        self.text = text
-        self.extra = extra
-        self.icons = icons or ()
-        self.subMenu = subMenu or Menu(is_root=False)
-        self.isActive = isActive
-        self.isCheckable = isCheckable
-        self.checked = checked
-        self.showCheckmark = self.isCheckable and showCheckmark
-
-    @property
-    def serializableContent(self):
+        # bypass __setattr__, there's nothing to invalidate yet.
+        self.__dict__.update(menu=None,
+                             _subMenu=None,
+                             _content=None,
+                             _json=None,
+                             id=id,
+                             text=text,
+                             extra=extra,
+                             icons=icons or (),
+                             isActive=isActive,
+                             isCheckable=isCheckable,
+                             checked=checked,
+                             showCheckmark=isCheckable and showCheckmark)
+        if subMenu:
+            self.setSubMenu(subMenu)
+
+    def __setattr__(self, name, value):
+        if name == "id" and self.menu is not None:
+            self.menu.unindexItem(self)
+            object.__setattr__(self, name, value)
+            self.menu.indexItem(self)
+        else:
+            object.__setattr__(self, name, value)
+
+        if name in MenuItem.serializedAttributes:
+            self.invalidate()
+
+    def invalidate(self):
+        # a valid parent cache is always built from valid child caches, so
+        # there's nothing left to do once we reach an invalid one.
+        if self._content is None and self._json is None:
+            return
+        object.__setattr__(self, "_content", None)
+        object.__setattr__(self, "_json", None)
+        if self.menu is not None:
+            self.menu.invalidate()
+
+    def flatContent(self):
         iconNormal = ""
         iconHover = ""
         iconInactive = ""
@@ -74,24 +121,54 @@ class MenuItem(QObject):
                 "itemIconInactive": iconInactive,
                 "itemText": self.text,
                 "itemExtra": self.extra,
-                "itemSubMenu": self.subMenu.serializableItemList,
                 "isActive": self.isActive,
                 "isCheckable": self.isCheckable,
                 "checked": self.checked,
                 "showCheckmark": self.showCheckmark}
 
+    @property
+    def serializableContent(self):
+        if self._content is None:
+            content = self.flatContent()
+            content["itemSubMenu"] = self._subMenu.serializableItemList if self._subMenu else EMPTY_MENU_CONTENT
+            object.__setattr__(self, "_content", content)
+        return self._content
+
+    @property
+    def serializedContent(self):
+        if self._json is None:
+            # splice the cached submenu json in instead of dumping the whole subtree again.
+            subMenuJson = str(self._subMenu) if self._subMenu else EMPTY_MENU_JSON
+            object.__setattr__(self, "_json", json.dumps(self.flatContent())[:-1] + ', "itemSubMenu": ' + subMenuJson + "}")
+        return self._json
+
+    @property
+    def subMenu(self):
+        if self._subMenu is None:
+            self.setSubMenu(Menu(is_root=False))
+        return self._subMenu
+
     def setSubMenu(self, menu):
-        self.subMenu = menu
+        if self.menu is not None:
+            self.menu.unindexItem(self)
+        if self._subMenu is not None:
+            self._subMenu.parentItem = None
+        object.__setattr__(self, "_subMenu", menu)
+        if menu is not None:
+            menu.parentItem = self
+        if self.menu is not None:
+            self.menu.indexItem(self)
+        self.invalidate()
 
     def setIcons(self, icons):
         self.icons = icons
 
     @property
     def hasSubMenu(self):
-        return len(self.subMenu.items) != 0
+        return self._subMenu is not None and len(self._subMenu.items) != 0
 
     def __str__(self):
-        return json.dumps(self.serializableContent)
+        return self.serializedContent
 
 class CheckableMenuItem(MenuItem):
     def __init__(self, id, text, checked=False, showCheckmark=True, extra=""):
@@ -107,41 +184,78 @@ class Menu(QObject):
     menuDismissed = pyqtSignal()
 
     def __init__(self, items=None, is_root=True, checkableMenu=False,
-        singleCheck=False):
+        singleCheck=False, keepWarm=False):
         super(Menu, self).__init__()
         self.items = []
-        if items:
-            parseMenu(self, items)
-        if is_root:
-            self.managerIface = MenuManagerInterface()
+        self.parentItem = None
+        # id -> item for this menu and all of its submenus.
+        self.itemIndex = {}
+        self._content = None
+        self._json = None
         self.menuIface = None
         self.checkableMenu = checkableMenu
         self.singleCheck = singleCheck
+        if items:
+            parseMenu(self, items)
+        # NOTE: RegisterMenu tears down whatever menu is up, in any client, so
+        # it's only called right before a show, never ahead of it. keepWarm
+        # keeps the proxies of the menu objects instead.
+        self.keepWarm = keepWarm
+        if is_root:
+            self.managerIface = sharedManagerInterface()
+
+    def invalidate(self):
+        if self._content is None and self._json is None:
+            return
+        self._content = None
+        self._json = None
+        if self.parentItem is not None:
+            self.parentItem.invalidate()
+
+    def ancestors(self):
+        menu = self
+        while menu is not None:
+            yield menu
+            menu = menu.parentItem.menu if menu.parentItem is not None else None
+
+    def indexEntries(self, item):
+        entries = dict(item._subMenu.itemIndex) if item._subMenu else {}
+        if item.id:
+            entries[item.id] = item
+        return entries
+
+    def indexItem(self, item):
+        entries = self.indexEntries(item)
+        for menu in self.ancestors():
+            menu.itemIndex.update(entries)
+
+    def unindexItem(self, item):
+        entries = self.indexEntries(item)
+        for menu in self.ancestors():
+            for id, indexed in entries.items():
+                if menu.itemIndex.get(id) is indexed:
+                    del menu.itemIndex[id]
 
     @property
     def serializableItemList(self):
-        items= []
-        for item in self.items:
-            items.append(item.serializableContent)
-        return {"items": items,
-                "checkableMenu": self.checkableMenu,
-                "singleCheck": self.singleCheck}
+        if self._content is None:
+            self._content = {"items": [item.serializableContent for item in self.items],
+                             "checkableMenu": self.checkableMenu,
+                             "singleCheck": self.singleCheck}
+        return self._content
 
     def addMenuItem(self, item):
         self.items.append(item)
+        item.menu = self
+        self.indexItem(item)
+        self.invalidate()
 
     def addMenuItems(self, items):
         for item in items:
             self.addMenuItem(item)
 
     def getItemById(self, id):
-        for item in self.items:
-            if item.hasSubMenu:
-                if item.subMenu.getItemById(id):
-                    return item.subMenu.getItemById(id)
-            if item.id == id:
-                return item
-        return None
+        return self.itemIndex.get(id)
 
     def setItemActivity(self, id, value):
         item = self.getItemById(id)
@@ -158,27 +272,52 @@ class Menu(QObject):
                 self.menuIface.setItemText(id, value)
 
     def showRectMenu(self, x, y):
-        msg = self.managerIface.registerMenu()
-        reply = QDBusReply(msg)
-        self.menuIface = MenuObjectInterface(reply.value())
-        self.menuIface.showMenu(json.dumps({"x": x,
-                                            "y": y,
-                                            "isDockMenu": False,
-                                            "menuJsonContent": str(self)}))
-        self.menuIface.ItemInvoked.connect(self.itemInvokedSlot)
-        self.menuIface.MenuUnregistered.connect(self.menuUnregisteredSlot)
+        self.showMenu({"x": x,
+                       "y": y,
+                       "isDockMenu": False})
 
     def showDockMenu(self, x, y, cornerDirection="down"):
-        msg = self.managerIface.registerMenu()
-        reply = QDBusReply(msg)
-        self.menuIface = MenuObjectInterface(reply.value())
-        self.menuIface.showMenu(json.dumps({"x": x,
-                                            "y": y,
-                                            "isDockMenu": True,
-                                            "cornerDirection": cornerDirection,
-                                            "menuJsonContent": str(self)}))
-        self.menuIface.ItemInvoked.connect(self.itemInvokedSlot)
-        self.menuIface.MenuUnregistered.connect(self.menuUnregisteredSlot)
+        self.showMenu({"x": x,
+                       "y": y,
+                       "isDockMenu": True,
+                       "cornerDirection": cornerDirection})
+
+    def showMenu(self, params):
+        def content():
+            params["menuJsonContent"] = str(self)
+            return json.dumps(params)
+
+        self.registerAndShow(content)
+
+    def registerAndShow(self, content):
+        # RegisterMenu goes out first, the menu is serialized while its
+        # reply is still on the way.
+        watcher = QDBusPendingCallWatcher(self.managerIface.registerMenuAsync(), self)
+        jsonContent = content()
+        watcher.finished.connect(lambda w: self.menuRegistered(w, jsonContent))
+
+    def menuRegistered(self, watcher, jsonContent):
+        watcher.deleteLater()
+        reply = QDBusPendingReply(watcher)
+        if reply.isError():
+            print "register menu failed: ", reply.error().message()
+            return
+        self.showOnMenuObject(objectPathString(reply.value()), jsonContent)
+
+    def showOnMenuObject(self, path, jsonContent):
+        if self.menuIface is None or self.menuIface.path() != path:
+            self.disconnectMenuObject()
+            self.menuIface = menuObjectInterface(path, self.keepWarm)
+            self.menuIface.ItemInvoked.connect(self.itemInvokedSlot)
+            self.menuIface.MenuUnregistered.connect(self.menuUnregisteredSlot)
+
+        self.menuIface.showMenu(jsonContent)
+
+    def disconnectMenuObject(self):
+        if self.menuIface is not None:
+            self.menuIface.ItemInvoked.disconnect(self.itemInvokedSlot)
+            self.menuIface.MenuUnregistered.disconnect(self.menuUnregisteredSlot)
+            self.menuIface = None
 
     @pyqtSlot(str, bool)
     def itemInvokedSlot(self, itemId, checked):
@@ -186,10 +325,17 @@ class Menu(QObject):
 
     @pyqtSlot()
     def menuUnregisteredSlot(self):
+        # the menu object is recycled and its path handed out to someone
+        # else later, stop listening to it.
+        self.disconnectMenuObject()
         self.menuDismissed.emit()
 
     def __str__(self):
-        return json.dumps(self.serializableItemList)
+        if self._json is None:
+            self._json = '{"items": [%s], "checkableMenu": %s, "singleCheck": %s}' % (
+                ", ".join(item.serializedContent for item in self.items),
+                json.dumps(self.checkableMenu), json.dumps(self.singleCheck))
+        return self._json
 
 class CheckboxMenu(Menu):
     def __init__(self, groupId, items):
@@ -201,7 +347,7 @@ class CheckboxMenu(Menu):
         validateItemGroupInfo(item, self.groupId, "checkbox")
         item.isCheckable = True
         item.showCheckmark = True
-        self.items.append(item)
+        super(CheckboxMenu, self).addMenuItem(item)
 
 class RadioButtonMenu(Menu):
     def __init__(self, groupId, items):
@@ -213,7 +359,7 @@ class RadioButtonMenu(Menu):
         validateItemGroupInfo(item, self.groupId, "radio")
         item.isCheckable = True
         item.showCheckmark = True
-        self.items.append(item)
+        super(RadioButtonMenu, self).addMenuItem(item)
 
 if __name__ == "__main__":
     import sys
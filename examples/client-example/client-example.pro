@@ -0,0 +1,12 @@
+QT       += core dbus
+QT       -= gui
+
+TARGET = deepin-menu-client-example
+TEMPLATE = app
+
+CONFIG += c++11 console
+
+INCLUDEPATH += $$PWD/../../client
+LIBS += -L$$OUT_PWD/../../client -ldeepin-menu-client
+
+SOURCES += main.cpp
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QDebug>
+
+#include "dmenuclient.h"
+
+// usage: deepin-menu-client-example [x y]
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    const QPoint pos = args.size() > 2 ? QPoint(args.at(1).toInt(), args.at(2).toInt()) : QPoint(200, 200);
+
+    DMenuBuilder menu;
+    menu.addItem("open", "Open").setItemIcon("document-open")
+        .addItem("rename", "Rename").setItemExtra("F2")
+        .addSeparator()
+        .beginSubMenu("sort", "Sort By")
+            .addRadioItem("sort", "name", "Name", true)
+            .addRadioItem("sort", "size", "Size")
+            .addRadioItem("sort", "time", "Time Modified")
+        .endSubMenu()
+        .addCheckboxItem("view", "hidden", "Show Hidden Files")
+        .addSeparator()
+        .addItem("properties", "Properties", false);
+
+    DMenuClient client;
+    QObject::connect(&client, &DMenuClient::error, [] (const QString &message) {
+        qWarning() << "menu error:" << message;
+        qApp->exit(1);
+    });
+
+    client.showMenu(menu, pos, true,
+                    [] (const QString &itemId, bool checked) {
+                        qDebug() << "item invoked:" << itemId << checked;
+                    },
+                    [] {
+                        qDebug() << "menu dismissed";
+                        qApp->quit();
+                    });
+
+    return app.exec();
+}
@@ -52,6 +52,18 @@ ManagerAdaptor::~ManagerAdaptor()
     // destructor
 }
 
+QStringList ManagerAdaptor::features() const
+{
+    // get the value of property Features
+    return qvariant_cast< QStringList >(parent()->property("Features"));
+}
+
+QVariantMap ManagerAdaptor::statistics() const
+{
+    // get the value of property Statistics
+    return qvariant_cast< QVariantMap >(parent()->property("Statistics"));
+}
+
 QDBusObjectPath ManagerAdaptor::RegisterMenu()
 {
     // handle method call com.deepin.menu.Manager.RegisterMenu
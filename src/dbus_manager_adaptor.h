@@ -57,6 +57,8 @@ class ManagerAdaptor: public QDBusAbstractAdaptor
 "    <method name=\"UnregisterMenu\">\n"
 "      <arg direction=\"in\" type=\"s\" name=\"menuObjectPath\"/>\n"
 "    </method>\n"
+"    <property access=\"read\" type=\"as\" name=\"Features\"/>\n"
+"    <property access=\"read\" type=\"a{sv}\" name=\"Statistics\"/>\n"
 "  </interface>\n"
         "")
 public:
@@ -64,6 +66,12 @@ public:
     virtual ~ManagerAdaptor();
 
 public: // PROPERTIES
+    Q_PROPERTY(QStringList Features READ features)
+    QStringList features() const;
+
+    Q_PROPERTY(QVariantMap Statistics READ statistics)
+    QVariantMap statistics() const;
+
 public Q_SLOTS: // METHODS
     QDBusObjectPath RegisterMenu();
     void UnregisterMenu(const QString &menuObjectPath);
@@ -36,6 +36,10 @@
 #include <QtCore/QStringList>
 #include <QtCore/QVariant>
 
+// HAND-EDIT
+#include "dcallrecorder.h"
+#include "menu_object.h"
+
 /*
  * Implementation of adaptor class MenuAdaptor
  */
@@ -55,24 +59,52 @@ MenuAdaptor::~MenuAdaptor()
 void MenuAdaptor::SetItemActivity(const QString &itemId, bool isActive)
 {
     // handle method call com.deepin.menu.Menu.SetItemActivity
+    // HAND-EDIT
+    if (!acceptCall())
+        return;
     QMetaObject::invokeMethod(parent(), "SetItemActivity", Q_ARG(QString, itemId), Q_ARG(bool, isActive));
 }
 
 void MenuAdaptor::SetItemChecked(const QString &itemId, bool checked)
 {
     // handle method call com.deepin.menu.Menu.SetItemChecked
+    // HAND-EDIT
+    if (!acceptCall())
+        return;
     QMetaObject::invokeMethod(parent(), "SetItemChecked", Q_ARG(QString, itemId), Q_ARG(bool, checked));
 }
 
 void MenuAdaptor::SetItemText(const QString &itemId, const QString &text)
 {
     // handle method call com.deepin.menu.Menu.SetItemText
+    // HAND-EDIT
+    if (!acceptCall())
+        return;
     QMetaObject::invokeMethod(parent(), "SetItemText", Q_ARG(QString, itemId), Q_ARG(QString, text));
 }
 
 void MenuAdaptor::ShowMenu(const QString &menuJsonContent)
 {
     // handle method call com.deepin.menu.Menu.ShowMenu
+    // HAND-EDIT
+    if (!acceptCall())
+        return;
     QMetaObject::invokeMethod(parent(), "ShowMenu", Q_ARG(QString, menuJsonContent));
 }
 
+// HAND-EDIT
+// pooled menu objects stay on the bus between checkouts, calls reaching one
+// which is recycled are stale and answered as if the path was gone.
+bool MenuAdaptor::acceptCall()
+{
+    if (!calledFromDBus())
+        return true;
+
+    if (!static_cast<MenuObject *>(parent())->isCheckedOut()) {
+        sendErrorReply(QDBusError::UnknownObject, "menu object is not registered");
+        return false;
+    }
+
+    DCallRecorder::instance()->record(message());
+    return true;
+}
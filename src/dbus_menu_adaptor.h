@@ -45,7 +45,9 @@ QT_END_NAMESPACE
 /*
  * Adaptor class for interface com.deepin.menu.Menu
  */
-class MenuAdaptor: public QDBusAbstractAdaptor
+// HAND-EDIT: QDBusContext gives the slots the calling message, which
+// DCallRecorder records.
+class MenuAdaptor: public QDBusAbstractAdaptor, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "com.deepin.menu.Menu")
@@ -71,6 +73,16 @@ class MenuAdaptor: public QDBusAbstractAdaptor
 "      <arg direction=\"out\" type=\"b\" name=\"checked\"/>\n"
 "    </signal>\n"
 "    <signal name=\"MenuUnregistered\"/>\n"
+"    <signal name=\"MenuShown\">\n"
+"      <arg direction=\"out\" type=\"s\" name=\"traceId\"/>\n"
+"      <arg direction=\"out\" type=\"a{sv}\" name=\"timings\"/>\n"
+"      <annotation value=\"QVariantMap\" name=\"org.qtproject.QtDBus.QtTypeName.Out1\"/>\n"
+"    </signal>\n"
+"    <signal name=\"ItemInvokedWithTrace\">\n"
+"      <arg direction=\"out\" type=\"s\" name=\"itemId\"/>\n"
+"      <arg direction=\"out\" type=\"b\" name=\"checked\"/>\n"
+"      <arg direction=\"out\" type=\"s\" name=\"traceId\"/>\n"
+"    </signal>\n"
 "  </interface>\n"
         "")
 public:
@@ -86,6 +98,12 @@ public Q_SLOTS: // METHODS
 Q_SIGNALS: // SIGNALS
     void ItemInvoked(const QString &itemId, bool checked);
     void MenuUnregistered();
+    void MenuShown(const QString &traceId, const QVariantMap &timings);
+    void ItemInvokedWithTrace(const QString &itemId, bool checked, const QString &traceId);
+
+private:
+    // HAND-EDIT
+    bool acceptCall();
 };
 
 #endif
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDBusMessage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QUuid>
+#include <QDebug>
+
+#include "dcallrecorder.h"
+
+static QString scrubText(QString text)
+{
+    for (QChar &c : text) {
+        if (c.isLetterOrNumber())
+            c = 'x';
+    }
+
+    return text;
+}
+
+// item ids often name the action ("copy", "open-with-gedit"), replace them
+// with a hash salted per recording, so they stay distinct and match between
+// ShowMenu and later calls but can't be looked up.
+static QString scrubId(const QString &id)
+{
+    static const QByteArray salt = QUuid::createUuid().toRfc4122();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(salt);
+    hash.addData(id.toUtf8());
+
+    return QString::fromLatin1(hash.result().toHex().left(12));
+}
+
+static QJsonArray scrubItems(const QJsonArray &items);
+
+static QJsonObject scrubItem(QJsonObject item)
+{
+    if (item.contains("itemId"))
+        item["itemId"] = scrubId(item["itemId"].toString());
+    item["itemText"] = scrubText(item["itemText"].toString());
+    if (item.contains("itemExtra"))
+        item["itemExtra"] = scrubText(item["itemExtra"].toString());
+
+    QJsonObject subMenu = item["itemSubMenu"].toObject();
+    if (!subMenu.isEmpty()) {
+        subMenu["items"] = scrubItems(subMenu["items"].toArray());
+        item["itemSubMenu"] = subMenu;
+    }
+
+    return item;
+}
+
+static QJsonArray scrubItems(const QJsonArray &items)
+{
+    QJsonArray result;
+    for (const QJsonValue &item : items)
+        result.append(scrubItem(item.toObject()));
+
+    return result;
+}
+
+// ShowMenu takes the menu either inline or as a JSON encoded string, keep
+// whichever form the client used.
+static QString scrubShowMenu(const QString &json)
+{
+    QJsonObject params = QJsonDocument::fromJson(json.toUtf8()).object();
+    const QJsonValue content = params["menuJsonContent"];
+
+    if (content.isObject()) {
+        QJsonObject contentObj = content.toObject();
+        contentObj["items"] = scrubItems(contentObj["items"].toArray());
+        params["menuJsonContent"] = contentObj;
+    } else {
+        QJsonObject contentObj = QJsonDocument::fromJson(content.toString().toUtf8()).object();
+        contentObj["items"] = scrubItems(contentObj["items"].toArray());
+        params["menuJsonContent"] = QString::fromUtf8(QJsonDocument(contentObj).toJson(QJsonDocument::Compact));
+    }
+
+    return QString::fromUtf8(QJsonDocument(params).toJson(QJsonDocument::Compact));
+}
+
+DCallRecorder::DCallRecorder(QObject *parent)
+    : QObject(parent)
+    , m_scrub(qgetenv("DEEPIN_MENU_RECORD_SCRUB") == "1")
+{
+    const QString fileName = QString::fromLocal8Bit(qgetenv("DEEPIN_MENU_RECORD"));
+    if (fileName.isEmpty())
+        return;
+
+    // one recording per file, the timestamps start over with every run.
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "can't record menu calls to" << fileName << m_file.errorString();
+        return;
+    }
+
+    qDebug() << "recording menu calls to" << fileName << (m_scrub ? "without item ids and texts" : "");
+    m_clock.start();
+}
+
+DCallRecorder *DCallRecorder::instance()
+{
+    static DCallRecorder *recorder = new DCallRecorder(qApp);
+    return recorder;
+}
+
+bool DCallRecorder::isRecording() const
+{
+    return m_file.isOpen();
+}
+
+void DCallRecorder::record(const QDBusMessage &message)
+{
+    if (!isRecording())
+        return;
+
+    QJsonArray args = QJsonArray::fromVariantList(message.arguments());
+    if (m_scrub) {
+        if (message.member() == "ShowMenu" && args.size() == 1) {
+            args[0] = scrubShowMenu(args.at(0).toString());
+        } else if (args.size() == 2) {
+            args[0] = scrubId(args.at(0).toString());
+            if (message.member() == "SetItemText")
+                args[1] = scrubText(args.at(1).toString());
+        }
+    }
+
+    QJsonObject call;
+    call["t"] = double(m_clock.nsecsElapsed() / 1000);
+    call["sender"] = message.service();
+    call["path"] = message.path();
+    call["method"] = message.member();
+    call["args"] = args;
+
+    m_file.write(QJsonDocument(call).toJson(QJsonDocument::Compact));
+    m_file.write("\n");
+    m_file.flush();
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DCALLRECORDER_H
+#define DCALLRECORDER_H
+
+#include <QObject>
+#include <QFile>
+#include <QElapsedTimer>
+
+class QDBusMessage;
+
+/**
+ * @brief DCallRecorder writes the menu calls clients make to a file, so
+ * real traffic can be replayed later by deepin-menu-replay.
+ *
+ * Recording is off unless DEEPIN_MENU_RECORD names the file to write to,
+ * an existing file is overwritten. With DEEPIN_MENU_RECORD_SCRUB=1 every
+ * letter and digit of item texts and extras is replaced, keeping their
+ * length and the shape of the menus, and item ids are replaced by salted
+ * hashes.
+ *
+ * The file has one compact JSON object per line:
+ * {"t": usecs since recording started, "sender", "path", "method", "args"}
+ */
+class DCallRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    static DCallRecorder *instance();
+
+    bool isRecording() const;
+    void record(const QDBusMessage &message);
+
+private:
+    explicit DCallRecorder(QObject *parent = nullptr);
+
+    QFile m_file;
+    bool m_scrub;
+    QElapsedTimer m_clock;
+};
+
+#endif // DCALLRECORDER_H
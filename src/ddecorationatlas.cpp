@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QPainter>
+
+#include "ddecorationatlas.h"
+
+static const char *DecorationFiles[] = {
+    ":/images/check_dark_normal.png",
+    ":/images/check_dark_hover.png",
+    ":/images/check_dark_inactive.png",
+    ":/images/check_light_normal.png",
+    ":/images/check_light_hover.png",
+    ":/images/check_light_inactive.png",
+    ":/images/arrow-light.png",
+    ":/images/arrow-light-hover.png",
+    ":/images/arrow-light-inactive.png",
+    ":/images/arrow-light.png"
+};
+
+static const QColor ArrowDarkColor("#303030");
+
+DDecorationAtlas::DDecorationAtlas(QObject *parent)
+    : QObject(parent)
+{
+    Q_STATIC_ASSERT(sizeof(DecorationFiles) / sizeof(DecorationFiles[0]) == DecorationCount);
+
+    m_images.reserve(DecorationCount);
+    for (const char *file : DecorationFiles)
+        m_images << QImage(file).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    // keep the shape, replace the color.
+    QImage &arrowDark = m_images[ArrowDark];
+    QPainter painter(&arrowDark);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+    painter.fillRect(arrowDark.rect(), ArrowDarkColor);
+    painter.end();
+}
+
+DDecorationAtlas *DDecorationAtlas::instance()
+{
+    static DDecorationAtlas *decorationAtlas = new DDecorationAtlas(qApp);
+    return decorationAtlas;
+}
+
+QSize DDecorationAtlas::size(Decoration decoration) const
+{
+    return m_images.at(decoration).size();
+}
+
+void DDecorationAtlas::draw(QPainter *painter, const QPoint &topLeft, Decoration decoration, qreal devicePixelRatio)
+{
+    const Atlas &decorations = atlas(devicePixelRatio);
+    painter->drawPixmap(QRectF(topLeft, size(decoration)), decorations.pixmap, decorations.rects.at(decoration));
+}
+
+/**
+ * @brief DDecorationAtlas::atlas lays the decorations out in a single row,
+ * scaled to devicePixelRatio, a pixel apart so that filtering never bleeds
+ * a neighbour in.
+ */
+const DDecorationAtlas::Atlas &DDecorationAtlas::atlas(qreal devicePixelRatio)
+{
+    auto it = m_atlases.constFind(devicePixelRatio);
+    if (it != m_atlases.constEnd())
+        return it.value();
+
+    Atlas decorations;
+    decorations.rects.reserve(DecorationCount);
+
+    QVector<QImage> scaled;
+    scaled.reserve(DecorationCount);
+
+    int width = 0;
+    int height = 0;
+    for (const QImage &image : m_images) {
+        const QImage scaledImage = qFuzzyCompare(devicePixelRatio, 1.0)
+                ? image
+                : image.scaled(image.size() * devicePixelRatio, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+        decorations.rects << QRect(QPoint(width, 0), scaledImage.size());
+        width += scaledImage.width() + 1;
+        height = qMax(height, scaledImage.height());
+        scaled << scaledImage;
+    }
+
+    QImage image(qMax(1, width), qMax(1, height), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (int i = 0; i < scaled.size(); i++)
+        painter.drawImage(decorations.rects.at(i).topLeft(), scaled.at(i));
+    painter.end();
+
+    decorations.pixmap = QPixmap::fromImage(image);
+
+    return m_atlases.insert(devicePixelRatio, decorations).value();
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DDECORATIONATLAS_H
+#define DDECORATIONATLAS_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QVector>
+
+class QPainter;
+
+/**
+ * @brief DDecorationAtlas packs the check marks and submenu arrows of
+ * images.qrc into one premultiplied pixmap per device pixel ratio.
+ *
+ * The images are decoded once per process, drawing a decoration is a blit
+ * of a sub-rect of the atlas.
+ */
+class DDecorationAtlas : public QObject
+{
+    Q_OBJECT
+public:
+    enum Decoration {
+        CheckDarkNormal,
+        CheckDarkHover,
+        CheckDarkInactive,
+        CheckLightNormal,
+        CheckLightHover,
+        CheckLightInactive,
+        ArrowLight,
+        ArrowLightHover,
+        ArrowLightInactive,
+        // arrow-light.png tinted for light backgrounds.
+        ArrowDark,
+        DecorationCount
+    };
+
+    static DDecorationAtlas *instance();
+
+    QSize size(Decoration decoration) const;
+    void draw(QPainter *painter, const QPoint &topLeft, Decoration decoration, qreal devicePixelRatio);
+
+private:
+    explicit DDecorationAtlas(QObject *parent = nullptr);
+
+    struct Atlas {
+        QPixmap pixmap;
+        // in device pixels.
+        QVector<QRect> rects;
+    };
+
+    const Atlas &atlas(qreal devicePixelRatio);
+
+    QVector<QImage> m_images;
+    QHash<qreal, Atlas> m_atlases;
+};
+
+#endif // DDECORATIONATLAS_H
@@ -18,69 +18,23 @@
  */
 
 #include "ddesktopmenu.h"
-
-#include <QJsonArray>
-#include <QJsonObject>
-#include <QDebug>
-#include <QKeyEvent>
-#include <QDBusPendingCall>
-#include <QTimer>
-#include <QApplication>
-#include <QScreen>
-#include <qpa/qplatformscreen.h>
+#include "dscreentopology.h"
 
 DDesktopMenu::DDesktopMenu()
-    : QMenu()
-    , m_monitor(new DRegionMonitor(this))
+    : DDockMenu()
 {
     setAccessibleName("DesktopMenu");
 
     // NOTE(hualet): don't change those window flags, if you delete below line, deepin-menu
     // won't even show working with deepin-terminal.
-    setWindowFlags(windowFlags() | Qt::ToolTip);
-
-    connect(m_monitor, &DRegionMonitor::buttonPress, this, [=] (const QPoint &p) {
-        for (auto *menu : m_ownMenus)
-            if (menu->geometry().contains(p))
-                return;
-
-        QTimer::singleShot(100, this, &DDesktopMenu::hide);
-    });
-}
-
-DDesktopMenu::~DDesktopMenu()
-{
-    m_monitor->unregisterRegion();
-    releaseKeyboard();
-}
-
-void DDesktopMenu::setItems(QJsonArray items)
-{
-    addActionFromJson(this, items);
-}
-
-void DDesktopMenu::setItemActivity(const QString &itemId, bool isActive)
-{
-    QAction *action = this->action(itemId);
-    if (action) {
-        action->setEnabled(isActive);
-    }
-}
+    // The arrow rectangle sets a window type of its own, replace it instead
+    // of or-ing the bits of both together.
+    setWindowFlags((windowFlags() & ~Qt::WindowType_Mask) | Qt::ToolTip);
 
-void DDesktopMenu::setItemChecked(const QString &itemId, bool checked)
-{
-    QAction *action = this->action(itemId);
-    if (action) {
-        action->setChecked(checked);
-    }
-}
-
-void DDesktopMenu::setItemText(const QString &itemId, const QString &text)
-{
-    QAction *action = this->action(itemId);
-    if (action) {
-        action->setText(text);
-    }
+    setAppearance(DesktopAppearance);
+    setArrowDirection(DArrowRectangle::ArrowLeft);
+    setArrowWidth(0);
+    setArrowHeight(0);
 }
 
 void DDesktopMenu::showMenu(const QPoint pos, bool isScaled)
@@ -91,107 +45,11 @@ void DDesktopMenu::showMenu(const QPoint pos, bool isScaled)
     }
 
     // 因为.dde_env已经不包含qt的缩放环境变量，所以收到的都是原始坐标
-    QList<QScreen *> oldList = qApp->screens();
-
     // 得到坐标所在的屏幕
-    for (auto it = oldList.constBegin(); it != oldList.constEnd(); ++it) {
-        QScreen const * currentScreen = (*it);
-        QRect rect = currentScreen->handle()->geometry();
-        const QPoint point = rect.topLeft();
+    const QRect rect = DScreenTopology::instance()->screenAtNative(handlePos).nativeGeometry;
+    const QPoint point = rect.topLeft();
 
-        if (rect.contains(handlePos)) {
-            // 计算接收坐标距离当前屏幕左边缘的长宽
-            // 保持原始的topleft和在当前屏幕内坐标的偏移就可以正常显示了
-            QMenu::popup(QPoint(rect.topLeft() + (handlePos - point) / devicePixelRatioF()));
-            break;
-        }
-    }
-}
-
-void DDesktopMenu::showEvent(QShowEvent *e)
-{
-    QMenu::showEvent(e);
-
-    m_monitor->registerRegion();
-
-    QTimer::singleShot(100, this, [=] {
-        activateWindow();
-        grabKeyboard();
-    });
-}
-
-void DDesktopMenu::hideEvent(QHideEvent *e)
-{
-    QMenu::hideEvent(e);
-
-    m_monitor->unregisterRegion();
-    releaseKeyboard();
-}
-
-void DDesktopMenu::keyPressEvent(QKeyEvent *event)
-{
-    if (event->key() == Qt::Key_Escape) {
-        hide();
-    }
-
-    QMenu::keyPressEvent(event);
-}
-
-QAction *DDesktopMenu::action(const QString &id)
-{
-    for (QAction *action : actions()) {
-        if (action->property("itemId") == id) {
-            return action;
-        }
-    }
-
-    return nullptr;
-}
-
-void DDesktopMenu::addActionFromJson(QMenu *menu, const QJsonArray &items)
-{
-    m_ownMenus << menu;
-
-    foreach (QJsonValue item, items) {
-        QJsonObject itemObj = item.toObject();
-        const QString itemText = itemObj["itemText"].toString().replace("_", QString()).replace(QRegExp("\\([^)]+\\)"), QString());
-        const QString itemIcon = itemObj["itemIcon"].toString();
-
-        const QJsonObject subMenuJson = itemObj["itemSubMenu"].toObject();
-        const QJsonArray subMenuItemsJson = subMenuJson["items"].toArray();
-
-        QAction *action = nullptr;
-        if (subMenuItemsJson.count()) {
-
-            QMenu *subMenu = new QMenu(menu);
-            action = menu->addMenu(subMenu);
-            addActionFromJson(subMenu, subMenuItemsJson);
-        } else if (itemText.isEmpty()) {
-            menu->addSeparator();
-            continue;
-        } else {
-            action = new QAction(menu);
-            menu->addAction(action);
-        }
-
-        action->setText(itemText);
-        action->setIcon(QIcon(itemIcon));
-
-        action->setEnabled(itemObj["isActive"].toBool());
-        action->setCheckable(itemObj["isCheckable"].toBool());
-        action->setChecked(itemObj["checked"].toBool());
-
-        action->setProperty("itemId", itemObj["itemId"].toString());
-
-        connect(action, &QAction::triggered, menu, [=] (const bool checked) {
-            const QString id = action->property("itemId").toString();
-
-            releaseFocus();
-            releaseMouse();
-            releaseKeyboard();
-            emit itemClicked(id, checked);
-
-            hide();
-        });
-    }
+    // 计算接收坐标距离当前屏幕左边缘的长宽
+    // 保持原始的topleft和在当前屏幕内坐标的偏移就可以正常显示了
+    popup(QPoint(rect.topLeft() + (handlePos - point) / devicePixelRatioF()));
 }
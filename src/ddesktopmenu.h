@@ -20,41 +20,22 @@
 #ifndef DDESKTOPMENU_H
 #define DDESKTOPMENU_H
 
-#include <QMenu>
-#include <dregionmonitor.h>
+#include "ddockmenu.h"
 
-#include "dabstractmenu.h"
-
-DWIDGET_USE_NAMESPACE
-
-class DDesktopMenu : public QMenu, public DAbstractMenu
+/**
+ * @brief DDesktopMenu is the context menu of the desktop and applications.
+ *
+ * It shares model, layout, hit-testing and painting with the dock menu and
+ * only differs in its light appearance and in popping up at the pointer
+ * instead of pointing at a dock item.
+ */
+class DDesktopMenu : public DDockMenu
 {
     Q_OBJECT
 public:
     explicit DDesktopMenu();
-    ~DDesktopMenu();
-
-    void setItems(QJsonArray items) Q_DECL_OVERRIDE;
-
-    void setItemActivity(const QString &itemId, bool isActive) Q_DECL_OVERRIDE;
-    void setItemChecked(const QString &itemId, bool checked) Q_DECL_OVERRIDE;
-    void setItemText(const QString &itemId, const QString &text) Q_DECL_OVERRIDE;
 
     void showMenu(const QPoint pos, bool isScaled);
-
-signals:
-    void itemClicked(const QString &id, bool checked);
-
-protected:
-    void showEvent(QShowEvent *e) Q_DECL_OVERRIDE;
-    void hideEvent(QHideEvent *e) Q_DECL_OVERRIDE;
-    void keyPressEvent(QKeyEvent *event) Q_DECL_OVERRIDE;
-
-private:
-    QAction *action(const QString &id);
-    void addActionFromJson(QMenu *menu, const QJsonArray &items);
-    DRegionMonitor *m_monitor;
-    QList<QMenu*> m_ownMenus;
 };
 
 #endif // DDESKTOPMENU_H
@@ -17,26 +17,89 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QGraphicsEffect>
 #include <QPainter>
 #include <QPainterPath>
+#include <QPaintEvent>
 #include <QRect>
 #include <QPen>
 #include <QBrush>
 #include <QHBoxLayout>
 #include <QJsonObject>
 #include <QDebug>
+#include <QLoggingCategory>
 #include <QJsonArray>
 #include <QApplication>
 #include <QScreen>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QWindow>
 
 #include "ddockmenu.h"
 #include "dmenucontent.h"
-#include "utils.h"
+#include "dscreentopology.h"
+#include "drendertier.h"
+
+// the average frame time of the render tier, enabled with
+// QT_LOGGING_RULES="deepin.menu.frames.debug=true".
+Q_LOGGING_CATEGORY(menuFrames, "deepin.menu.frames", QtInfoMsg)
+// how many pointer moves a menu got and how many were hit-tested, enabled
+// with QT_LOGGING_RULES="deepin.menu.motion.debug=true".
+Q_LOGGING_CATEGORY(menuMotion, "deepin.menu.motion", QtInfoMsg)
+
+QT_BEGIN_NAMESPACE
+// from qpixmapfilter.cpp, what QGraphicsDropShadowEffect blurs with.
+extern Q_WIDGETS_EXPORT void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool quality, bool alphaOnly, int transposed = 0);
+QT_END_NAMESPACE
+
+static const QColor ShadowColor(0, 0, 0, 100);
+
+// the region monitor reports wheel turns as presses of buttons 4 to 7.
+static const int FirstWheelButton = 4;
+
+// how long the pointer has to rest on a row before its submenu opens.
+static const int SubMenuDelay = 100;
+// how long a move towards the open submenu may take before the rows it
+// crossed get selected anyway.
+static const int HoverIntentTimeout = 300;
+
+static bool triangleContains(const QPoint &a, const QPoint &b, const QPoint &c, const QPoint &p)
+{
+    auto cross = [](const QPoint &o, const QPoint &u, const QPoint &v) {
+        return qint64(u.x() - o.x()) * (v.y() - o.y()) - qint64(u.y() - o.y()) * (v.x() - o.x());
+    };
+
+    const qint64 d1 = cross(a, b, p);
+    const qint64 d2 = cross(b, c, p);
+    const qint64 d3 = cross(c, a, p);
+
+    const bool hasNegative = d1 < 0 || d2 < 0 || d3 < 0;
+    const bool hasPositive = d1 > 0 || d2 > 0 || d3 > 0;
+
+    return !(hasNegative && hasPositive);
+}
 
 DDockMenu::DDockMenu(DDockMenu *parent)
     : DArrowRectangle(DArrowRectangle::ArrowBottom, parent)
     , m_menuContent(new DMenuContent(this))
+    , m_model(new DMenuModel)
+    , m_appearance(DockAppearance)
     , m_monitor(new DRegionMonitor(this))
+    , m_anchorMode(NoAnchor)
+    , m_flipX(false)
+    , m_flipY(false)
+    , m_shadowDirty(false)
+    , m_renderingShadow(false)
+    , m_contentDirection(ArrowBottom)
+    , m_motionTimer(new QTimer(this))
+    , m_motionPending(false)
+    , m_motionReceived(0)
+    , m_motionProcessed(0)
+    , m_subMenu(nullptr)
+    , m_subMenuItem(-1)
+    , m_subMenuTimer(new QTimer(this))
+    , m_hoverIntentTimer(new QTimer(this))
+    , m_dismissed(false)
 {
     setAttribute(Qt::WA_InputMethodEnabled, false);
 
@@ -44,38 +107,75 @@ DDockMenu::DDockMenu(DDockMenu *parent)
 
     m_wmHelper = DWindowManagerHelper::instance();
 
-    connect(m_wmHelper, &DWindowManagerHelper::hasCompositeChanged, this, &DDockMenu::onWMCompositeChanged);
+#if DTK_VERSION >= DTK_VERSION_CHECK(5, 5, 0, 0)
+    // only clicks are taken from the region monitor, motion comes from the
+    // menu's own mouse events and keys from its keyboard grab. Without this
+    // every cursor move on the screen is sent to the service over the bus.
+    m_monitor->setRegisterFlags(DRegionMonitor::Button);
+#endif
 
-    onWMCompositeChanged();
+    connect(m_wmHelper, &DWindowManagerHelper::hasCompositeChanged, this, &DDockMenu::onWMCompositeChanged);
+    connect(DRenderTier::instance(), &DRenderTier::tierChanged, this, &DDockMenu::onRenderTierChanged);
 
     setAccessibleName("DockMenu");
-    setBackgroundColor(DBlurEffectWidget::DarkColor);
     setMargin(0);
     setArrowWidth(18);
     setArrowHeight(10);
 
-    normalStyle = ItemStyle{Qt::transparent,
-            Qt::white,
-            QColor("#646464"),
-            ":/images/check_dark_normal.png",
-            ":/images/arrow-dark.png"};
-    hoverStyle = ItemStyle{QColor("#2ca7f8"),
-            Qt::white,
-            QColor("#646464"),
-            ":/images/check_dark_hover.png",
-            ":/images/arrow-dark.png"};
-    inactiveStyle = ItemStyle{Qt::transparent,
-            QColor("#646464"),
-            QColor("#646464"),
-            ":/images/check_dark_inactive.png",
-            ":/images/arrow-dark.png"};
-
-    connect(m_monitor, &DRegionMonitor::buttonPress, this, [=] (const QPoint &p) {
-        if (geometry().contains(p)) {
-            // The action performed is not from QAction and needs to be postponed because the menu requires a hover style.
-            QTimer::singleShot(100, this, [=] {
-                m_menuContent->processButtonClick(p);
-            });
+    m_shadowBlurRadius = shadowBlurRadius();
+    m_shadowYOffset = shadowYOffset();
+    if (QGraphicsEffect *effect = graphicsEffect()) {
+        effect->setEnabled(false);
+        m_shadowDirty = true;
+    }
+    setAppearance(parent ? parent->m_appearance : DockAppearance);
+
+    m_motionTimer->setSingleShot(true);
+    m_motionTimer->setTimerType(Qt::PreciseTimer);
+    m_motionTimer->setInterval(16);
+    connect(m_motionTimer, &QTimer::timeout, this, [this] {
+        if (!m_motionPending)
+            return;
+
+        processPendingMotion();
+        m_motionTimer->start();
+    });
+
+    m_subMenuTimer->setSingleShot(true);
+    m_subMenuTimer->setInterval(SubMenuDelay);
+    connect(m_subMenuTimer, &QTimer::timeout, this, &DDockMenu::openSubMenu);
+
+    m_hoverIntentTimer->setSingleShot(true);
+    m_hoverIntentTimer->setInterval(HoverIntentTimeout);
+    connect(m_hoverIntentTimer, &QTimer::timeout, this, [this] {
+        if (m_menuContent->processCursorMove(m_lastCursorPos))
+            m_motionProcessed++;
+    });
+
+    if (parent) {
+        // submenus are placed by their parent, right next to its row.
+        setArrowDirection(DArrowRectangle::ArrowLeft);
+        setArrowWidth(0);
+        setArrowHeight(0);
+        setContent(m_menuContent);
+    }
+
+    // only the root menu monitors clicks, for the whole menu stack.
+    connect(m_monitor, &DRegionMonitor::buttonPress, this, [=] (const QPoint &p, const int flag) {
+        // the menu may still be on screen, transparent, on its way out.
+        if (m_dismissed)
+            return;
+
+        DDockMenu *menu = menuUnderPoint(p);
+        if (menu) {
+            // scrolling over the menu doesn't click the row under it.
+            if (flag >= FirstWheelButton)
+                return;
+
+            // invoke first: resolve the item under the press right away,
+            // hovers are coalesced and may lag behind the cursor.
+            menu->m_menuContent->processCursorMove(p);
+            menu->m_menuContent->processButtonClick(p);
         } else {
             qDebug() << "window deactivate, destroy menu";
             destroyAll();
@@ -85,7 +185,12 @@ DDockMenu::DDockMenu(DDockMenu *parent)
 
 DDockMenu::~DDockMenu()
 {
-    m_monitor->unregisterRegion();
+    qCDebug(menuMotion) << "motion events received:" << m_motionReceived
+                        << "hit-tested:" << m_motionProcessed;
+    qCDebug(menuFrames) << "average frame time (us):" << DRenderTier::instance()->averagePaintTime() / 1000;
+
+    if (m_monitor->registered())
+        m_monitor->unregisterRegion();
     setVisible(false);
     releaseFocus();
     releaseKeyboard();
@@ -93,53 +198,243 @@ DDockMenu::~DDockMenu()
 
 void DDockMenu::setItems(QJsonArray items)
 {
-    m_menuContent->setCurrentIndex(-1);
-    m_menuContent->clearActions();
+    QSharedPointer<DMenuModel> model(new DMenuModel);
+    model->build(items);
+
+    setModel(model);
+}
+
+/**
+ * @brief DDockMenu::setModel shows the items of a model built beforehand,
+ * possibly on another thread. The model must not be modified elsewhere
+ * once handed over.
+ */
+void DDockMenu::setModel(const QSharedPointer<DMenuModel> &model)
+{
+    hideSubMenu();
+
+    m_model = model;
+    m_menuContent->setModel(m_model.data(), 0, m_model->rootCount());
+
+    setContent(m_menuContent);
+
+    updateContentSize();
+}
+
+void DDockMenu::setItemActivity(const QString &itemId, bool isActive)
+{
+    const int item = m_model->indexOf(itemId);
+    if (item < 0)
+        return;
 
-    foreach (QJsonValue item, items) {
-        QJsonObject itemObj = item.toObject();
+    m_model->setActive(item, isActive);
+    updateMenus();
+}
 
-        QAction *action = new QAction(m_menuContent);
-        QString itemText = itemObj["itemText"].toString().replace("_", QString()).replace(QRegExp("\\([^)]+\\)"), QString());
+void DDockMenu::setItemChecked(const QString &itemId, bool checked)
+{
+    const int item = m_model->indexOf(itemId);
+    if (item < 0)
+        return;
 
-        action->setText(itemText);
-        action->setEnabled(itemObj["isActive"].toBool());
-        action->setCheckable(itemObj["isCheckable"].toBool() || Utils::menuItemCheckableFromId(itemObj["itemId"].toString()));
-        action->setChecked(itemObj["checked"].toBool());
-        action->setProperty("itemId", itemObj["itemId"].toString());
-        action->setProperty("itemIcon", itemObj["itemIcon"].toString());
-        action->setProperty("itemIconHover", itemObj["itemIconHover"].toString());
-        action->setProperty("itemIconInactive", itemObj["itemIconInactive"].toString());
-        action->setProperty("itemSubMenu", itemObj["itemSubMenu"].toObject());
+    m_model->setChecked(item, checked);
+    updateMenus();
+}
 
-        m_menuContent->addAction(action);
+void DDockMenu::setItemText(const QString &itemId, const QString &text)
+{
+    const int item = m_model->indexOf(itemId);
+    if (item < 0)
+        return;
+
+    m_model->setText(item, text);
+    for (DDockMenu *menu = this; menu; menu = menu->m_subMenu) {
+        menu->m_menuContent->invalidateFilterIndex();
+        menu->m_menuContent->invalidateLayout();
     }
+    updateMenus();
+}
 
-    // adjust its size according to its content.
-    m_menuContent->setFixedSize(m_menuContent->contentWidth(),
-                                m_menuContent->contentHeight());
+DDockMenu *DDockMenu::getRootMenu()
+{
+    DDockMenu *root = this;
+    while (root->parentMenu())
+        root = root->parentMenu();
 
+    return root;
+}
 
-    setContent(m_menuContent);
+DDockMenu *DDockMenu::parentMenu() const
+{
+    return qobject_cast<DDockMenu *>(parent());
+}
+
+/**
+ * @brief DDockMenu::activeMenu
+ * @return the innermost open menu having a selected row, which is the one
+ * keyboard input goes to.
+ */
+DDockMenu *DDockMenu::activeMenu()
+{
+    DDockMenu *menu = getRootMenu();
+    while (menu->m_subMenu && menu->m_subMenu->isVisible()
+           && menu->m_subMenu->m_menuContent->currentIndex() >= 0)
+        menu = menu->m_subMenu;
+
+    return menu;
+}
+
+/**
+ * @brief DDockMenu::model
+ * @return the model of the whole menu tree, owned by the root menu.
+ */
+DMenuModel &DDockMenu::model()
+{
+    return *getRootMenu()->m_model;
+}
+
+void DDockMenu::updateContentSize()
+{
+    const QSize size(m_menuContent->contentWidth(), m_menuContent->contentHeight());
+
+    // the arrow rectangle rebuilds its path, border and masks on every
+    // resize, even to the size it already has. Submenus are reused for
+    // all rows, so siblings of the same size get them for free.
+    if (size == m_contentSize && arrowDirection() == m_contentDirection)
+        return;
+
+    m_contentSize = size;
+    m_contentDirection = arrowDirection();
+
+    // adjust its size according to its content.
+    m_menuContent->setFixedSize(size);
 
     resizeWithContent();
+
+    // the filter resizes open menus, keep them at what they were opened
+    // from, an arrow on the dock item it points at.
+    if (isVisible() && m_anchorMode != NoAnchor)
+        placeAtAnchor();
 }
 
-DDockMenu *DDockMenu::getRootMenu()
+void DDockMenu::updateMenus()
+{
+    for (DDockMenu *menu = this; menu; menu = menu->m_subMenu)
+        menu->m_menuContent->update();
+}
+
+/**
+ * @brief DDockMenu::showSubMenu is called whenever the selected row changes.
+ * @param x, y the global position of the top right corner of the row.
+ * @param item the model index of the row, -1 if it's inactive.
+ *
+ * The submenu of the row is built right away and only shown once the
+ * pointer rested on the row for a moment.
+ */
+void DDockMenu::showSubMenu(int x, int y, int item)
+{
+    m_subMenuTimer->stop();
+
+    if (item < 0 || !model().hasSubMenu(item)) {
+        hideSubMenu();
+        return;
+    }
+
+    m_subMenuPos = QPoint(x, y);
+    if (m_subMenuItem == item && m_subMenu->isVisible())
+        return;
+
+    prepareSubMenu(item);
+    m_subMenuTimer->start();
+}
+
+void DDockMenu::prepareSubMenu(int item)
+{
+    if (!m_subMenu)
+        m_subMenu = new DDockMenu(this);
+
+    if (m_subMenuItem == item)
+        return;
+
+    hideSubMenu();
+    m_subMenuItem = item;
+
+    DMenuModel &menuModel = model();
+    m_subMenu->m_menuContent->setModel(&menuModel, menuModel.childBegin(item), menuModel.childCount(item));
+    m_subMenu->updateContentSize();
+
+    // have the native window ready, so opening it is just a map.
+    m_subMenu->ensurePolished();
+    m_subMenu->winId();
+}
+
+void DDockMenu::openSubMenu()
+{
+    m_subMenuTimer->stop();
+
+    if (!m_subMenu || m_subMenuItem < 0 || m_subMenu->isVisible())
+        return;
+
+    const QRect screen = DScreenTopology::instance()->screenAt(m_subMenuPos).geometry;
+    const QRect menuRect = geometry();
+    const QSize size = m_subMenu->size();
+
+    // open to the right unless there's no room for it, line the first row
+    // of the submenu up with the parent row.
+    int x = menuRect.right() + 1;
+    if (x + size.width() > screen.right() + 1)
+        x = menuRect.left() - size.width();
+
+    const int y = m_subMenuPos.y() - m_subMenu->m_menuContent->y();
+
+    m_subMenu->move(DScreenTopology::clamp(QRect(QPoint(x, y), size), screen));
+    m_subMenu->setVisible(true);
+    m_subMenu->raise();
+}
+
+/**
+ * @brief DDockMenu::closeSubMenu hides the submenu but keeps it built for
+ * the selected row, so it can be opened again from the keyboard.
+ */
+void DDockMenu::closeSubMenu()
+{
+    m_subMenuTimer->stop();
+    m_hoverIntentTimer->stop();
+
+    if (!m_subMenu)
+        return;
+
+    m_subMenu->hideSubMenu();
+    m_subMenu->setVisible(false);
+}
+
+void DDockMenu::hideSubMenu()
 {
-    return this;
+    closeSubMenu();
+    m_subMenuItem = -1;
 }
 
-void DDockMenu::showSubMenu(int, int, const QJsonObject &)
+/**
+ * @brief DDockMenu::isHeadingForSubMenu tells whether the pointer moving
+ * from from to to stays within the triangle spanned by from and the near
+ * edge of the open submenu.
+ */
+bool DDockMenu::isHeadingForSubMenu(const QPoint &from, const QPoint &to) const
 {
+    if (!m_subMenu || !m_subMenu->isVisible() || from == to)
+        return false;
 
+    const QRect subMenuRect = m_subMenu->geometry();
+    const int edge = subMenuRect.left() >= geometry().right() ? subMenuRect.left() : subMenuRect.right();
+
+    return triangleContains(from, QPoint(edge, subMenuRect.top()), QPoint(edge, subMenuRect.bottom()), to);
 }
 
 bool DDockMenu::event(QEvent *event)
 {
-    if (event->type() == QEvent::WindowDeactivate) {
+    if (event->type() == QEvent::WindowDeactivate && !parentMenu()) {
         // NOTE(sbw): test if we have mouse handle
-        if (rect().contains(mapFromGlobal(QCursor::pos())))
+        if (menuUnderPoint(QCursor::pos()))
         {
             activateWindow();
         } else {
@@ -152,11 +447,41 @@ bool DDockMenu::event(QEvent *event)
         qDebug() << pos();
     }
 
+    // the arrow rectangle rebuilds its shape when resized or shown.
+    if ((event->type() == QEvent::Resize || event->type() == QEvent::Show) && graphicsEffect())
+        m_shadowDirty = true;
+
+    // an update request repaints and flushes the whole window, background,
+    // blur and content, which is what a frame costs.
+    if (event->type() == QEvent::UpdateRequest) {
+        QElapsedTimer frameTimer;
+        frameTimer.start();
+
+        if (m_shadowDirty)
+            updateShadow();
+
+        const bool result = DArrowRectangle::event(event);
+        DRenderTier::instance()->reportPaintTime(frameTimer.nsecsElapsed());
+
+        return result;
+    }
+
     return DArrowRectangle::event(event);
 }
 
 void DDockMenu::showEvent(QShowEvent *e)
 {
+    // one frame of the screen the menu shows up on.
+    QScreen *screen = windowHandle() ? windowHandle()->screen() : qApp->primaryScreen();
+    if (screen && screen->refreshRate() > 0)
+        m_motionTimer->setInterval(qMax(1, qRound(1000 / screen->refreshRate())));
+
+    // submenus leave the pointer and the keyboard to the root menu.
+    if (parentMenu()) {
+        DArrowRectangle::showEvent(e);
+        return;
+    }
+
     Q_ASSERT(!m_monitor->registered());
     m_monitor->registerRegion();
 
@@ -176,36 +501,138 @@ void DDockMenu::hideEvent(QHideEvent *event)
 {
     DArrowRectangle::hideEvent(event);
 
-    m_monitor->unregisterRegion();
+    if (m_monitor->registered())
+        m_monitor->unregisterRegion();
     releaseKeyboard();
 }
 
+void DDockMenu::paintEvent(QPaintEvent *event)
+{
+    // hovers repaint a row, which only blits the part of the shadow under it.
+    if (!m_shadow.isNull() && !m_renderingShadow) {
+        QPainter painter(this);
+        painter.setClipRegion(event->region());
+        painter.drawPixmap(QPointF(shadowXOffset(), shadowYOffset()), m_shadow);
+    }
+
+    DArrowRectangle::paintEvent(event);
+}
+
+/**
+ * @brief DDockMenu::updateShadow renders the menu shape once without its
+ * content, blurs its alpha and keeps the result for every repaint until
+ * the shape changes.
+ */
+void DDockMenu::updateShadow()
+{
+    m_shadowDirty = false;
+    m_shadow = QPixmap();
+
+    const qreal radius = shadowBlurRadius();
+    if (radius <= 0 || size().isEmpty())
+        return;
+
+    const qreal ratio = devicePixelRatioF();
+    QImage shape(size() * ratio, QImage::Format_ARGB32_Premultiplied);
+    shape.setDevicePixelRatio(ratio);
+    shape.fill(Qt::transparent);
+
+    m_renderingShadow = true;
+    render(&shape, QPoint(), QRegion(), RenderFlags());
+    m_renderingShadow = false;
+
+    QImage shadow(shape.size(), QImage::Format_ARGB32_Premultiplied);
+    shadow.fill(Qt::transparent);
+
+    QPainter painter(&shadow);
+    qt_blurImage(&painter, shape, radius * ratio, false, true);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+    painter.fillRect(shadow.rect(), ShadowColor);
+    painter.end();
+
+    m_shadow = QPixmap::fromImage(shadow);
+    m_shadow.setDevicePixelRatio(ratio);
+}
+
 void DDockMenu::mouseMoveEvent(QMouseEvent *event)
 {
     DArrowRectangle::mouseMoveEvent(event);
 
-    m_menuContent->processCursorMove(mapToGlobal(event->pos()));
+    m_motionReceived++;
+    m_pendingCursorPos = mapToGlobal(event->pos());
+
+    // the first move after a quiet frame is handled right away, the ones
+    // following it within the same frame only leave their position behind.
+    if (m_motionTimer->isActive()) {
+        m_motionPending = true;
+        return;
+    }
+
+    processPendingMotion();
+    m_motionTimer->start();
+}
+
+void DDockMenu::processPendingMotion()
+{
+    m_motionPending = false;
+
+    const QPoint from = m_lastCursorPos;
+    m_lastCursorPos = m_pendingCursorPos;
+
+    if (isHeadingForSubMenu(from, m_lastCursorPos)) {
+        m_hoverIntentTimer->start();
+        return;
+    }
+    m_hoverIntentTimer->stop();
+
+    if (m_menuContent->processCursorMove(m_lastCursorPos))
+        m_motionProcessed++;
 }
 
 void DDockMenu::keyPressEvent(QKeyEvent *event)
 {
     DArrowRectangle::keyPressEvent(event);
 
+    // the root menu has the keyboard, the innermost menu in use handles it.
+    DDockMenu *menu = activeMenu();
+    DMenuContent *content = menu->m_menuContent;
+
     switch (event->key()) {
     case Qt::Key_Escape:
-        destroyAll();
+        if (content->isFiltering())
+            content->clearFilter();
+        else if (menu->parentMenu())
+            menu->parentMenu()->closeSubMenu();
+        else
+            destroyAll();
+        break;
+    case Qt::Key_Backspace:
+        content->removeFilterText();
         break;
     case Qt::Key_Return:
     case Qt::Key_Enter:
-        m_menuContent->doCurrentAction();
+        content->doCurrentAction();
         break;
     case Qt::Key_Up:
-        m_menuContent->selectPrevious();
+        content->selectPrevious();
         break;
     case Qt::Key_Down:
-        m_menuContent->selectNext();
+        content->selectNext();
+        break;
+    case Qt::Key_Right:
+        if (menu->m_subMenuItem >= 0) {
+            menu->openSubMenu();
+            menu->m_subMenu->m_menuContent->selectNext();
+        }
+        break;
+    case Qt::Key_Left:
+        if (menu->parentMenu())
+            menu->parentMenu()->closeSubMenu();
         break;
     default:
+        // type-ahead, filter the items by the text typed so far.
+        if (!event->text().isEmpty() && event->text().at(0).isPrint())
+            content->appendFilterText(event->text());
         break;
     }
 }
@@ -217,7 +644,26 @@ void DDockMenu::keyPressEvent(QKeyEvent *event)
  */
 DDockMenu *DDockMenu::menuUnderPoint(const QPoint point)
 {
-    return geometry().contains(point) ? this : nullptr;
+    // submenus always stack on top of their parents, the innermost open
+    // menu containing the point wins. geometry() is cached by QWidget, so
+    // this is a single rect test per level.
+    DDockMenu *result = nullptr;
+    for (DDockMenu *menu = getRootMenu(); menu && menu->isVisible(); menu = menu->m_subMenu) {
+        if (menu->geometry().contains(point))
+            result = menu;
+    }
+
+    return result;
+}
+
+quint64 DDockMenu::motionEventsReceived() const
+{
+    return m_motionReceived;
+}
+
+quint64 DDockMenu::motionEventsProcessed() const
+{
+    return m_motionProcessed;
 }
 
 void DDockMenu::releaseFocus()
@@ -228,22 +674,224 @@ void DDockMenu::releaseFocus()
     releaseKeyboard();
 }
 
+void DDockMenu::setAppearance(Appearance appearance)
+{
+    m_appearance = appearance;
+
+    switch (appearance) {
+    case DockAppearance:
+        normalStyle = ItemStyle{Qt::transparent,
+                Qt::white,
+                QColor("#646464"),
+                DDecorationAtlas::CheckDarkNormal,
+                DDecorationAtlas::ArrowLight};
+        hoverStyle = ItemStyle{QColor("#2ca7f8"),
+                Qt::white,
+                QColor("#646464"),
+                DDecorationAtlas::CheckDarkHover,
+                DDecorationAtlas::ArrowLightHover};
+        inactiveStyle = ItemStyle{Qt::transparent,
+                QColor("#646464"),
+                QColor("#646464"),
+                DDecorationAtlas::CheckDarkInactive,
+                DDecorationAtlas::ArrowLightInactive};
+        break;
+    case DesktopAppearance:
+        normalStyle = ItemStyle{Qt::transparent,
+                QColor("#303030"),
+                QColor("#8c8c8c"),
+                DDecorationAtlas::CheckLightNormal,
+                DDecorationAtlas::ArrowDark};
+        hoverStyle = ItemStyle{QColor("#2ca7f8"),
+                Qt::white,
+                QColor("#e6e6e6"),
+                DDecorationAtlas::CheckLightHover,
+                DDecorationAtlas::ArrowLightHover};
+        inactiveStyle = ItemStyle{Qt::transparent,
+                QColor("#b4b4b4"),
+                QColor("#b4b4b4"),
+                DDecorationAtlas::CheckLightInactive,
+                DDecorationAtlas::ArrowLightInactive};
+        break;
+    }
+
+    onWMCompositeChanged();
+    onRenderTierChanged();
+    m_menuContent->update();
+
+    if (m_subMenu)
+        m_subMenu->setAppearance(appearance);
+}
+
+/**
+ * @brief DDockMenu::showAt shows a menu having an arrow pointing at pos.
+ * @param pos is a global position.
+ */
+void DDockMenu::showAt(const QPoint &pos)
+{
+    m_anchor = pos;
+    m_anchorMode = ArrowAnchor;
+    placeAtAnchor();
+
+    setVisible(true);
+    raise();
+}
+
+/**
+ * @brief DDockMenu::popup shows a menu having no arrow with the top left
+ * corner of its first row at pos, the way QMenu::popup does.
+ * @param pos is a global position.
+ */
+void DDockMenu::popup(const QPoint &pos)
+{
+    m_anchor = pos;
+    m_anchorMode = PopupAnchor;
+    placeAtAnchor();
+
+    setVisible(true);
+    raise();
+}
+
+/**
+ * @brief DDockMenu::placeAtAnchor places the root menu by the position it
+ * was opened at, again whenever its size changes while it's open.
+ */
+void DDockMenu::placeAtAnchor()
+{
+    const QRect screen = DScreenTopology::instance()->screenAt(m_anchor).geometry;
+    const QSize size = this->size();
+
+    if (m_anchorMode == ArrowAnchor) {
+        // the arrow rectangle lines its centered arrow up with the anchor,
+        // the menu is then kept on the screen of the anchor and the arrow
+        // follows to still point at it.
+        setArrowX(0);
+        setArrowY(0);
+        DArrowRectangle::move(m_anchor.x(), m_anchor.y());
+
+        const QRect placed = geometry();
+        const QPoint topLeft = DScreenTopology::clamp(placed, screen);
+
+        if (topLeft != placed.topLeft()) {
+            switch (arrowDirection()) {
+            case ArrowTop:
+            case ArrowBottom:
+                setArrowX(m_anchor.x() - topLeft.x());
+                break;
+            case ArrowLeft:
+            case ArrowRight:
+                setArrowY(m_anchor.y() - topLeft.y());
+                break;
+            }
+            QWidget::move(topLeft);
+        }
+        return;
+    }
+
+    // flip to the other side of the anchor if there's no room, decided when
+    // shown so that shrinking doesn't move the menu over. Leave the shadow
+    // around the content out of the placement.
+    QPoint topLeft = m_anchor - m_menuContent->pos();
+    if (!isVisible()) {
+        m_flipX = topLeft.x() + size.width() > screen.right() + 1;
+        m_flipY = topLeft.y() + size.height() > screen.bottom() + 1;
+    }
+    if (m_flipX)
+        topLeft.rx() -= m_menuContent->width();
+    if (m_flipY)
+        topLeft.ry() -= m_menuContent->height();
+
+    move(DScreenTopology::clamp(QRect(topLeft, size), screen));
+}
+
 void DDockMenu::destroyAll()
 {
+    // submenus are children of the root menu and go away with it.
+    if (parentMenu()) {
+        getRootMenu()->destroyAll();
+        return;
+    }
+
+    if (m_dismissed)
+        return;
+    m_dismissed = true;
+
+    // clicks are not for a menu on its way out any more.
+    if (m_monitor->registered())
+        m_monitor->unregisterRegion();
+
+    // the menu vanishes on this very frame. With a compositor the window is
+    // only made transparent, see below. Without one opacity does nothing, so
+    // it's unmapped right away.
+    const bool composited = m_wmHelper->hasComposite();
+    for (DDockMenu *menu = this; menu; menu = menu->m_subMenu) {
+        if (composited)
+            menu->setWindowOpacity(0);
+        else
+            menu->hide();
+    }
+
     // NOTE(hualet): the events processed by this menu is actually delivered by
     // xmousearea which is xrecord backed, so if we destroy this window too
     // early, say immediately after mouse clicks, the actual events will go to
     // the window behide the menu(desktop for example).
-    QTimer::singleShot(100, this, [this] {
-        qApp->processEvents();
-        deleteLater();
-    });
+    // A button pressed on the menu keeps its window until the button goes
+    // up, the release reaches us through the implicit grab.
+    if (QGuiApplication::mouseButtons() != Qt::NoButton) {
+        qApp->installEventFilter(this);
+        return;
+    }
+
+    finishDismissal();
+}
+
+void DDockMenu::finishDismissal()
+{
+    for (DDockMenu *menu = this; menu; menu = menu->m_subMenu)
+        menu->hide();
+
+    deleteLater();
+}
+
+bool DDockMenu::eventFilter(QObject *watched, QEvent *event)
+{
+    // only installed while a dismissed menu waits for the button to go up.
+    if (event->type() == QEvent::MouseButtonRelease && QGuiApplication::mouseButtons() == Qt::NoButton) {
+        qApp->removeEventFilter(this);
+        finishDismissal();
+    }
+
+    return DArrowRectangle::eventFilter(watched, event);
 }
 
 void DDockMenu::onWMCompositeChanged()
 {
     if (m_wmHelper->hasComposite())
         setBorderColor(QColor(255, 255, 255, 0));
+    else if (m_appearance == DesktopAppearance)
+        setBorderColor(QColor("#c8c8c8"));
     else
         setBorderColor(QColor("#2C3238"));
 }
+
+void DDockMenu::onRenderTierChanged()
+{
+    if (DRenderTier::instance()->isLowCost()) {
+        // opaque and flat, nothing has to be rendered offscreen.
+        setBlurBackgroundEnabled(false);
+        setBackgroundColor(m_appearance == DesktopAppearance ? QColor("#f8f8f8") : QColor("#252525"));
+        setShadowBlurRadius(0);
+        setShadowYOffset(0);
+    } else {
+        setBlurBackgroundEnabled(true);
+        setBackgroundColor(m_appearance == DesktopAppearance ? DBlurEffectWidget::LightColor : DBlurEffectWidget::DarkColor);
+        setShadowBlurRadius(m_shadowBlurRadius);
+        setShadowYOffset(m_shadowYOffset);
+    }
+
+    // the shape is painted in the new background color.
+    if (graphicsEffect()) {
+        m_shadowDirty = true;
+        update();
+    }
+}
@@ -20,7 +20,11 @@
 #ifndef DDOCKMENU_H
 #define DDOCKMENU_H
 
+#include <QSharedPointer>
+
 #include "dabstractmenu.h"
+#include "dmenumodel.h"
+#include "ddecorationatlas.h"
 #include <dregionmonitor.h>
 #include <darrowrectangle.h>
 #include <DWindowManagerHelper>
@@ -32,51 +36,132 @@ struct ItemStyle {
     QColor itemBackgroundColor;
     QColor itemTextColor;
     QColor itemShortcutColor;
-    QString checkmarkIcon;
-    QString subMenuIndicatorIcon;
+    DDecorationAtlas::Decoration checkmark;
+    DDecorationAtlas::Decoration subMenuIndicator;
 };
 
+class QTimer;
 class DMenuContent;
 class DDockMenu : public DArrowRectangle, public DAbstractMenu
 {
     Q_OBJECT
 public:
+    // colors and decorations, submenus take over the one of their root.
+    enum Appearance {
+        DockAppearance,
+        DesktopAppearance
+    };
+
     explicit DDockMenu(DDockMenu *parent = nullptr);
     ~DDockMenu() override;
 
     void setItems(QJsonArray items) Q_DECL_OVERRIDE;
+    void setModel(const QSharedPointer<DMenuModel> &model);
+
+    void setItemActivity(const QString &itemId, bool isActive) Q_DECL_OVERRIDE;
+    void setItemChecked(const QString &itemId, bool checked) Q_DECL_OVERRIDE;
+    void setItemText(const QString &itemId, const QString &text) Q_DECL_OVERRIDE;
 
     void releaseFocus() Q_DECL_OVERRIDE;
 
+    void setAppearance(Appearance appearance);
+    void showAt(const QPoint &pos);
+    void popup(const QPoint &pos);
     void destroyAll();
 
+    quint64 motionEventsReceived() const;
+    quint64 motionEventsProcessed() const;
+
 signals:
     void itemClicked(const QString &id, bool checked);
 
 private slots:
     void onWMCompositeChanged();
+    void onRenderTierChanged();
 
 private:
     DDockMenu *getRootMenu();
+    DDockMenu *parentMenu() const;
+    DDockMenu *activeMenu();
     DDockMenu *menuUnderPoint(const QPoint point);
-    void showSubMenu(int x, int y, const QJsonObject &obj );
+    DMenuModel &model();
+    void updateContentSize();
+    void updateMenus();
+    void showSubMenu(int x, int y, int item);
+    void prepareSubMenu(int item);
+    void openSubMenu();
+    void closeSubMenu();
+    void hideSubMenu();
+    bool isHeadingForSubMenu(const QPoint &from, const QPoint &to) const;
+    void processPendingMotion();
+    void finishDismissal();
+    void placeAtAnchor();
+    void updateShadow();
 
 protected:
     bool event(QEvent *event) Q_DECL_OVERRIDE;
+    bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
     void showEvent(QShowEvent *e) Q_DECL_OVERRIDE;
     void hideEvent(QHideEvent *event) Q_DECL_OVERRIDE;
+    void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
     void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
     void keyPressEvent(QKeyEvent *event) override;
 
 private:
     friend class DMenuContent;
     DMenuContent *m_menuContent;
+    // the model of the whole tree, submenus show ranges of their root's.
+    QSharedPointer<DMenuModel> m_model;
 
+    Appearance m_appearance;
     ItemStyle normalStyle;
     ItemStyle hoverStyle;
     ItemStyle inactiveStyle;
     DRegionMonitor *m_monitor;
     DWindowManagerHelper *m_wmHelper;
+    // where the root menu was opened, submenus are placed by their parent.
+    enum AnchorMode {
+        NoAnchor,
+        ArrowAnchor,
+        PopupAnchor
+    };
+    QPoint m_anchor;
+    AnchorMode m_anchorMode;
+    bool m_flipX;
+    bool m_flipY;
+
+    qreal m_shadowBlurRadius;
+    qreal m_shadowYOffset;
+    // without dxcb the arrow rectangle draws its shadow with a graphics
+    // effect, blurring the whole window on every repaint. The shadow of the
+    // menu shape is rendered once instead, again when the shape changes.
+    QPixmap m_shadow;
+    bool m_shadowDirty;
+    bool m_renderingShadow;
+    // what the window was last sized for.
+    QSize m_contentSize;
+    ArrowDirection m_contentDirection;
+
+    // pointer moves are hit-tested at most once per frame.
+    QTimer *m_motionTimer;
+    QPoint m_pendingCursorPos;
+    bool m_motionPending;
+    quint64 m_motionReceived;
+    quint64 m_motionProcessed;
+
+    // the one submenu of this menu, reused for every row having one.
+    DDockMenu *m_subMenu;
+    int m_subMenuItem;
+    QPoint m_subMenuPos;
+    QTimer *m_subMenuTimer;
+    // keeps the selection while the pointer crosses rows on its way to
+    // the open submenu.
+    QTimer *m_hoverIntentTimer;
+    QPoint m_lastCursorPos;
+
+    // set once an item was invoked or the menu was dismissed otherwise,
+    // the windows only wait for their teardown from then on.
+    bool m_dismissed;
 };
 
 #endif // DDOCKMENU_H
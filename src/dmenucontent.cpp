@@ -20,7 +20,6 @@
 #include <QRect>
 #include <QPainter>
 #include <QBrush>
-#include <QAction>
 #include <QtGlobal>
 #include <QMouseEvent>
 #include <QKeyEvent>
@@ -30,12 +29,14 @@
 #include <QJsonArray>
 #include <QPoint>
 #include <QStaticText>
+#include <QPixmapCache>
 #include <QDebug>
 #include <QApplication>
 
-#include "utils.h"
 #include "dmenucontent.h"
+#include "dmenumodel.h"
 #include "ddockmenu.h"
+#include "utils.h"
 
 #define MENU_ITEM_MAX_WIDTH 500
 #define SEPARATOR_HEIGHT 6
@@ -43,11 +44,22 @@
 
 static const int LeftRightPadding = 20;
 static const int TopBottomPadding = 4;
+static const int IconSize = 16;
+static const int ColumnSpacing = 8;
 
 DMenuContent::DMenuContent(DDockMenu *parent) :
     QWidget(parent),
-    _currentIndex(-1)
+    _currentIndex(-1),
+    _model(nullptr),
+    _firstItem(0),
+    _itemCount(0),
+    _contentWidth(-1)
 {
+    _iconWidth = 0;
+    _shortcutWidth = 0;
+    _subMenuIndicatorWidth = 0;
+    _textWidth = 0;
+
     this->setMouseTracking(true);
 }
 
@@ -63,37 +75,116 @@ void DMenuContent::setCurrentIndex(int index)
     _currentIndex = index;
     this->update();
 
-    if (index < 0 || index >= this->actions().count()) return;
+    if (index >= rowCount()) return;
 
     DDockMenu *parent = qobject_cast<DDockMenu*>(this->parent());
     Q_ASSERT(parent);
 
-    QAction *action = this->actions().at(index);
+    const int item = modelIndex(index);
     QRect actionRect = this->getRectOfActionAtIndex(index);
+    _currentRowRect = actionRect;
     QPoint point = this->mapToGlobal(QPoint(this->width(), actionRect.y()));
-    QString itemId = action->property("itemId").toString();
 
-    QString prop("%1Active");
-    QVariant activeCache = parent->getRootMenu()->property(prop.arg(itemId).toLatin1());
-    bool active = activeCache.isNull() ? action->isEnabled() : activeCache.toBool();
+    parent->showSubMenu(point.x(), point.y(), _model->isActive(item) ? item : -1);
+}
 
-    QJsonObject subMenuJsonObj = active ?
-                this->actions().at(index)->property("itemSubMenu").value<QJsonObject>()
-              : QJsonObject();
-    parent->showSubMenu(point.x(), point.y(), subMenuJsonObj);
+/**
+ * @brief DMenuContent::setModel shows the items [first, first + count) of model.
+ * The model is owned by the menu, it must outlive this content.
+ */
+void DMenuContent::setModel(DMenuModel *model, int first, int count)
+{
+    _model = model;
+    _firstItem = first;
+    _itemCount = count;
+    _contentWidth = -1;
+    _currentIndex = -1;
+    _currentRowRect = QRect();
+
+    _filterText.clear();
+    _filterStack.clear();
+    _foldedTexts.clear();
+    _foldedOffsets.clear();
+
+    this->update();
+}
+
+int DMenuContent::itemCount() const
+{
+    return _itemCount;
 }
 
 int DMenuContent::contentWidth()
 {
-    int result = 0;
+    if (_contentWidth < 0)
+        updateLayout();
+
+    return _contentWidth;
+}
+
+void DMenuContent::invalidateLayout()
+{
+    _contentWidth = -1;
+}
 
+/**
+ * @brief DMenuContent::updateLayout measures the icon, text, shortcut and
+ * submenu indicator columns of all items in one sweep. The widths are kept
+ * until the items change, painting only elides texts known to be too wide.
+ */
+void DMenuContent::updateLayout()
+{
     QFontMetrics metrics(font());
 
-    foreach (QAction *action, this->actions()) {
-        result = qMax(result, metrics.width(action->text()));
+    bool hasIcon = false;
+    bool hasSubMenu = false;
+    int shortcutWidth = 0;
+
+    _textWidth = 0;
+    _textWidths.resize(_itemCount);
+
+    // measure all items, the width is kept while filtering.
+    for (int i = 0; i < _itemCount; i++) {
+        const int item = _firstItem + i;
+
+        _textWidths[i] = metrics.width(_model->text(item));
+        _textWidth = qMax(_textWidth, _textWidths.at(i));
+
+        const QString extra = _model->extra(item);
+        if (!extra.isEmpty())
+            shortcutWidth = qMax(shortcutWidth, metrics.width(extra));
+
+        hasIcon = hasIcon || !_model->icon(item, DMenuModel::IconNormal).isEmpty();
+        hasSubMenu = hasSubMenu || _model->hasSubMenu(item);
+    }
+
+    _iconWidth = hasIcon ? IconSize + ColumnSpacing : 0;
+    _shortcutWidth = shortcutWidth > 0 ? ColumnSpacing + shortcutWidth : 0;
+    _subMenuIndicatorWidth = 0;
+    if (hasSubMenu) {
+        DDockMenu *parent = qobject_cast<DDockMenu*>(this->parent());
+        Q_ASSERT(parent);
+        _subMenuIndicatorWidth = DDecorationAtlas::instance()->size(parent->normalStyle.subMenuIndicator).width()
+                + ColumnSpacing;
     }
 
-    return qMin(MENU_ITEM_MAX_WIDTH, result + 10 + LeftRightPadding*2);
+    _contentWidth = qMin(MENU_ITEM_MAX_WIDTH,
+                         LeftRightPadding + _iconWidth + _textWidth + 10 + _shortcutWidth + rightPadding());
+}
+
+// the submenu indicator is centered in the right padding, which grows if
+// the indicator doesn't fit.
+int DMenuContent::rightPadding() const
+{
+    return qMax(LeftRightPadding, _subMenuIndicatorWidth);
+}
+
+int DMenuContent::rowHeight(int index, const QFontMetrics &metrics) const
+{
+    if (_model->isSeparator(modelIndex(index)))
+        return SEPARATOR_HEIGHT;
+
+    return metrics.height() + MENU_ITEM_TOP_BOTTOM_PADDING * 2;
 }
 
 int DMenuContent::contentHeight()
@@ -101,8 +192,8 @@ int DMenuContent::contentHeight()
     int result = 0;
 
     QFontMetrics fm(font());
-    foreach (QAction *action, this->actions()) {
-        if (action->text().isEmpty()) {
+    for (int i = 0; i < rowCount(); i++) {
+        if (_model->isSeparator(modelIndex(i))) {
             result += SEPARATOR_HEIGHT;
         } else {
             result += fm.height() + MENU_ITEM_TOP_BOTTOM_PADDING * 2;
@@ -114,25 +205,22 @@ int DMenuContent::contentHeight()
 
 void DMenuContent::doCurrentAction()
 {
-    if (_currentIndex < 0 || _currentIndex >= this->actions().count()) return;
+    if (_currentIndex < 0 || _currentIndex >= rowCount()) return;
 
     DDockMenu *parent = qobject_cast<DDockMenu*>(this->parent());
     Q_ASSERT(parent);
 
-    QAction *currentAction = this->actions().at(_currentIndex);
-    QString itemId = currentAction->property("itemId").toString();
-    QString prop("%1Checked");
-    QVariant checkedCache = parent->getRootMenu()->property(prop.arg(itemId).toLatin1());
-    bool checked = checkedCache.isNull() ? currentAction->isChecked() : checkedCache.toBool();
-    bool currentActionHasSubMenu = currentAction->property("itemSubMenu").value<QJsonObject>()["items"].toArray().count() != 0;
-    prop = QString("%1Activity");
-    QVariant activeCache = parent->getRootMenu()->property(prop.arg(itemId).toLatin1());
-    bool active = activeCache.isNull() ? currentAction->isEnabled() : activeCache.toBool();
+    const int item = modelIndex(_currentIndex);
 
-    if (!active || currentAction->text().isEmpty() || currentActionHasSubMenu) return;
+    if (!_model->isActive(item) || _model->isSeparator(item)) return;
 
-    if (currentAction->isCheckable()) {
-        if (checked) {
+    if (_model->hasSubMenu(item)) {
+        parent->openSubMenu();
+        return;
+    }
+
+    if (_model->isCheckable(item)) {
+        if (_model->isChecked(item)) {
             this->doUnCheck(_currentIndex);
         } else {
             this->doCheck(_currentIndex);
@@ -140,31 +228,62 @@ void DMenuContent::doCurrentAction()
     } else {
         parent->releaseFocus();
 
-        this->sendItemClickedSignal(currentAction->property("itemId").toString(), false);
+        this->sendItemClickedSignal(_model->itemId(item), false);
     }
     qDebug() << "do action, destroy all";
     parent->destroyAll();
 }
 
+/**
+ * @brief DMenuContent::renderToImage paints the rows into an image instead of the
+ * window, so menus can be looked at and timed without mapping anything.
+ * @param devicePixelRatio the ratio to render at, independent of any screen.
+ * @param hoveredRow the row painted as hovered, -1 for none.
+ */
+QImage DMenuContent::renderToImage(qreal devicePixelRatio, int hoveredRow)
+{
+    const QSize size(contentWidth(), contentHeight());
+
+    QImage image(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    paint(&painter, size.width(), devicePixelRatio, hoveredRow);
+    painter.end();
+
+    return image;
+}
+
 // override methods
 void DMenuContent::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    paint(&painter, width(), devicePixelRatioF(), _currentIndex);
+    painter.end();
+}
+
+void DMenuContent::paint(QPainter *painter, int width, qreal devicePixelRatio, int hoveredRow)
 {
     DDockMenu *parent = qobject_cast<DDockMenu*>(this->parent());
 
-    QPainter painter(this);
+    if (_contentWidth < 0)
+        updateLayout();
 
-    for(int i = 0; i < this->actions().count(); i++) {
-        QAction *action = this->actions().at(i);
-        QRect actionRect = this->getRectOfActionAtIndex(i);
-        QString itemId = action->property("itemId").toString();
+    QFontMetrics metrics(font());
+    DDecorationAtlas *decorations = DDecorationAtlas::instance();
 
-        QString prop("%1Activity");
-        QVariant activeCache = parent->getRootMenu()->property(prop.arg(itemId).toLatin1());
-        bool active = activeCache.isNull() ? action->isEnabled() : activeCache.toBool();
-        ItemStyle itemStyle = active ? i == _currentIndex ? parent->hoverStyle : parent->normalStyle : parent->inactiveStyle;
+    // rows follow each other, walking them keeps painting linear.
+    int rowTop = TopBottomPadding;
+    for(int i = 0; i < rowCount(); i++) {
+        const int item = modelIndex(i);
+        const QRect actionRect(0, rowTop, width, rowHeight(i, metrics));
+        rowTop += actionRect.height();
+
+        ItemStyle itemStyle = _model->isActive(item) ? i == hoveredRow ? parent->hoverStyle : parent->normalStyle : parent->inactiveStyle;
 
         // indicates that this item is a separator
-        if (action->text().isEmpty()) {
+        if (_model->isSeparator(item)) {
             int topLineX1 = actionRect.x() + 4;
             int topLineY1 = actionRect.y() + (actionRect.height() - 2) / 2;
             int topLineX2 = actionRect.x() + actionRect.width() - 4;
@@ -173,36 +292,103 @@ void DMenuContent::paintEvent(QPaintEvent *)
             int bottomLineY1 = topLineY1 + 1;
             int bottomLineX2 = topLineX2;
             int bottomLineY2 = topLineY1 + 1;
-            painter.setPen(QPen(QColor::fromRgbF(0, 0, 0, 0.1)));
-            painter.drawLine(topLineX1, topLineY1, topLineX2, topLineY2);
-            painter.setPen(QPen(QColor::fromRgbF(1, 1, 1, 0.1)));
-            painter.drawLine(bottomLineX1, bottomLineY1, bottomLineX2, bottomLineY2);
+            painter->setPen(QPen(QColor::fromRgbF(0, 0, 0, 0.1)));
+            painter->drawLine(topLineX1, topLineY1, topLineX2, topLineY2);
+            painter->setPen(QPen(QColor::fromRgbF(1, 1, 1, 0.1)));
+            painter->drawLine(bottomLineX1, bottomLineY1, bottomLineX2, bottomLineY2);
         } else {
-            painter.fillRect(actionRect, QBrush(itemStyle.itemBackgroundColor));
-            painter.setPen(QPen(itemStyle.itemTextColor));
+            painter->fillRect(actionRect, QBrush(itemStyle.itemBackgroundColor));
 
-            // draw text
-            QString prop("%1Text");
-            QVariant textCache = parent->getRootMenu()->property(prop.arg(itemId).toLatin1());
-            QString text = textCache.isNull() ? action->text() : textCache.toString();
-            QString elidedText = elideText(text, actionRect.width() - LeftRightPadding * 2);
+            // columns: check mark in the left padding, icon, text, shortcut
+            // and the submenu indicator in the right padding.
+            QRect columnsRect(actionRect);
+            columnsRect.adjust(LeftRightPadding, 0, -rightPadding(), 0);
+
+            if (_iconWidth > 0) {
+                const QPixmap icon = iconPixmap(item, i == hoveredRow, devicePixelRatio);
+                if (!icon.isNull())
+                    painter->drawPixmap(columnsRect.left(), columnsRect.center().y() - IconSize / 2, icon);
+            }
+
+            QRect textRect(columnsRect);
+            textRect.adjust(_iconWidth, 0, -_shortcutWidth, 0);
 
             QTextOption option;
             option.setAlignment(Qt::AlignVCenter | Qt::AlignLeft);
 
-            QRect textRect(actionRect);
-            textRect.adjust(LeftRightPadding, 0, -LeftRightPadding, 0);
-            painter.drawText(textRect, elidedText, option);
+            QString text = _model->text(item);
+            if (_textWidths.at(item - _firstItem) > textRect.width())
+                text = metrics.elidedText(text, Qt::ElideRight, textRect.width());
+
+            painter->setPen(QPen(itemStyle.itemTextColor));
+            painter->drawText(textRect, text, option);
+
+            if (_shortcutWidth > 0) {
+                const QString extra = _model->extra(item);
+                if (!extra.isEmpty()) {
+                    option.setAlignment(Qt::AlignVCenter | Qt::AlignRight);
+                    painter->setPen(QPen(itemStyle.itemShortcutColor));
+                    painter->drawText(columnsRect, extra, option);
+                }
+            }
+
+            if (_model->isChecked(item)) {
+                const QSize size = decorations->size(itemStyle.checkmark);
+                const QPoint topLeft(actionRect.left() + (LeftRightPadding - size.width()) / 2,
+                                     actionRect.center().y() - size.height() / 2);
+                decorations->draw(painter, topLeft, itemStyle.checkmark, devicePixelRatio);
+            }
+            if (_model->hasSubMenu(item)) {
+                const QSize size = decorations->size(itemStyle.subMenuIndicator);
+                const QPoint topLeft(actionRect.right() - (rightPadding() + size.width()) / 2,
+                                     actionRect.center().y() - size.height() / 2);
+                decorations->draw(painter, topLeft, itemStyle.subMenuIndicator, devicePixelRatio);
+            }
         }
     }
+}
 
-    painter.end();
+/**
+ * @brief DMenuContent::iconPixmap loads the icon of item for its current
+ * state, icons are shared through QPixmapCache between menus.
+ */
+QPixmap DMenuContent::iconPixmap(int item, bool hovered, qreal ratio) const
+{
+    QString path = _model->icon(item, DMenuModel::IconNormal);
+    if (!_model->isActive(item) && !_model->icon(item, DMenuModel::IconInactive).isEmpty())
+        path = _model->icon(item, DMenuModel::IconInactive);
+    else if (hovered && !_model->icon(item, DMenuModel::IconHover).isEmpty())
+        path = _model->icon(item, DMenuModel::IconHover);
+
+    if (path.isEmpty())
+        return QPixmap();
+
+    const QString key = QString("deepin-menu-icon-%1-%2-%3").arg(path).arg(IconSize).arg(ratio);
+
+    QPixmap pixmap;
+    if (!QPixmapCache::find(key, &pixmap)) {
+        pixmap = QIcon(path).pixmap(QSize(IconSize, IconSize) * ratio);
+        pixmap.setDevicePixelRatio(ratio);
+        QPixmapCache::insert(key, pixmap);
+    }
+
+    return pixmap;
 }
 
-void DMenuContent::processCursorMove(const QPoint &p)
+/**
+ * @brief DMenuContent::processCursorMove selects the row under p.
+ * @return false if the cursor is still on the current row and nothing had
+ * to be hit-tested.
+ */
+bool DMenuContent::processCursorMove(const QPoint &p)
 {
+    if (_currentIndex >= 0 && _currentRowRect.contains(mapFromGlobal(p)))
+        return false;
+
     int index = itemIndexUnderEvent(p);
     setCurrentIndex(index);
+
+    return true;
 }
 
 void DMenuContent::processButtonClick(const QPoint &p)
@@ -220,89 +406,151 @@ void DMenuContent::processButtonClick(const QPoint &p)
     }
 }
 
-// private methods
-QRect DMenuContent::getRectOfActionAtIndex(int index)
+bool DMenuContent::isFiltering() const
 {
-    QFontMetrics fm(font());
+    return !_filterText.isEmpty();
+}
+
+/**
+ * @brief DMenuContent::appendFilterText narrows the visible items down to
+ * the ones containing the filter text. Only the items which survived the
+ * previous keystroke are searched, keystrokes which would leave nothing
+ * visible are ignored.
+ */
+void DMenuContent::appendFilterText(const QString &text)
+{
+    if (_foldedOffsets.isEmpty())
+        buildFilterIndex();
 
-    auto getItemHeight = [this, &fm](const int i) {
-        QAction *action = this->actions().at(i);
-        if (action->text().isEmpty()) {
-            return SEPARATOR_HEIGHT;
+    bool changed = false;
+
+    for (const QChar &c : text) {
+        const QString filterText = _filterText + c.toCaseFolded();
+        QVector<int> rows;
+
+        if (_filterStack.isEmpty()) {
+            for (int row = 0; row < _itemCount; row++) {
+                if (rowMatches(row, filterText))
+                    rows << row;
+            }
         } else {
-            return fm.height() + MENU_ITEM_TOP_BOTTOM_PADDING * 2;
+            for (int row : _filterStack.last()) {
+                if (rowMatches(row, filterText))
+                    rows << row;
+            }
         }
-    };
 
-    int previousHeight = TopBottomPadding;
-    int itemHeight = getItemHeight(index);
+        if (rows.isEmpty())
+            break;
 
-    for (int i = 0; i < index; i++) {
-        int height = getItemHeight(i);
-        previousHeight += height;
+        _filterText = filterText;
+        _filterStack << rows;
+        changed = true;
     }
 
-    return QRect(0, previousHeight, this->width(), itemHeight);
+    if (changed)
+        filterChanged();
 }
 
-void DMenuContent::clearActions()
+void DMenuContent::removeFilterText()
 {
-    foreach (QAction *action, this->actions()) {
-        this->removeAction(action);
-    }
+    if (!isFiltering())
+        return;
+
+    _filterText.chop(1);
+    _filterStack.removeLast();
+
+    filterChanged();
 }
 
-int DMenuContent::getNextItemsHasShortcut(int startPos, QString keyText) {
-    if (keyText.isEmpty()) return -1;
+void DMenuContent::clearFilter()
+{
+    if (!isFiltering())
+        return;
 
-    DDockMenu *parent = qobject_cast<DDockMenu*>(this->parent());
-    Q_ASSERT(parent);
+    _filterText.clear();
+    _filterStack.clear();
 
-    for (int i = qMax(startPos, 0); i < this->actions().count(); i++) {
-        QString itemId(this->actions().at(i)->property("itemId").toString());
-        QAction *action = this->actions().at(i);
+    filterChanged();
+}
 
-        QString prop("%1Active");
-        QVariant activeCache = parent->getRootMenu()->property(prop.arg(itemId).toLatin1());
-        bool active = activeCache.isNull() ? action->isEnabled() : activeCache.toBool();
+void DMenuContent::invalidateFilterIndex()
+{
+    _foldedTexts.clear();
+    _foldedOffsets.clear();
+}
 
-        // a trick here, using currentIndex as the cursor.
-        if (active && keyText == this->actions().at(i)->property("itemNavKey").toString().toLower()){
-            return i;
-        }
-    }
+// private methods
+int DMenuContent::rowCount() const
+{
+    return _filterStack.isEmpty() ? _itemCount : _filterStack.last().size();
+}
 
-    // we do the check another time to support wrapping.
-    for (int i = 0; i < this->actions().count(); i++) {
-        QString itemId(this->actions().at(i)->property("itemId").toString());
-        QAction *action = this->actions().at(i);
+int DMenuContent::modelIndex(int index) const
+{
+    return _filterStack.isEmpty() ? _firstItem + index : _firstItem + _filterStack.last().at(index);
+}
 
-        QString prop("%1Active");
-        QVariant activeCache = parent->getRootMenu()->property(prop.arg(itemId).toLatin1());
-        bool active = activeCache.isNull() ? action->isEnabled() : activeCache.toBool();
+void DMenuContent::buildFilterIndex()
+{
+    _foldedTexts.clear();
+    _foldedOffsets.resize(_itemCount + 1);
 
-        if (active && keyText == this->actions().at(i)->property("itemNavKey").toString().toLower()) {
-            return i;
-        }
+    for (int row = 0; row < _itemCount; row++) {
+        _foldedOffsets[row] = _foldedTexts.size();
+        _foldedTexts.append(_model->text(_firstItem + row).toCaseFolded());
     }
-    return -1;
+    _foldedOffsets[_itemCount] = _foldedTexts.size();
 }
 
-void DMenuContent::selectPrevious()
+bool DMenuContent::rowMatches(int row, const QString &filterText) const
+{
+    const int item = _firstItem + row;
+    if (_model->isSeparator(item))
+        return false;
+
+    const QStringRef text(&_foldedTexts, _foldedOffsets.at(row), _foldedOffsets.at(row + 1) - _foldedOffsets.at(row));
+    return text.contains(filterText);
+}
+
+void DMenuContent::filterChanged()
 {
     DDockMenu *parent = qobject_cast<DDockMenu*>(this->parent());
     Q_ASSERT(parent);
 
-    for (int i = currentIndex() - 1; i >= 0; i--) {
-        QAction * action = actions().at(i);
+    _currentIndex = -1;
+    _currentRowRect = QRect();
+    for (int i = 0; i < rowCount(); i++) {
+        if (_model->isActive(modelIndex(i))) {
+            setCurrentIndex(i);
+            break;
+        }
+    }
 
-        QString itemId(action->property("itemId").toString());
+    parent->updateContentSize();
+    this->update();
+}
+
+QRect DMenuContent::getRectOfActionAtIndex(int index)
+{
+    QFontMetrics fm(font());
 
-        QString prop("%1Active");
-        QVariant activeCache = parent->getRootMenu()->property(prop.arg(itemId).toLatin1());
-        bool active = activeCache.isNull() ? action->isEnabled() : activeCache.toBool();
+    int previousHeight = TopBottomPadding;
+    int itemHeight = rowHeight(index, fm);
 
-        if (active && !action->text().isEmpty()) {
+    for (int i = 0; i < index; i++) {
+        previousHeight += rowHeight(i, fm);
+    }
+
+    return QRect(0, previousHeight, this->width(), itemHeight);
+}
+
+void DMenuContent::selectPrevious()
+{
+    for (int i = currentIndex() - 1; i >= 0; i--) {
+        const int item = modelIndex(i);
+
+        if (_model->isActive(item) && !_model->isSeparator(item)) {
             setCurrentIndex(i);
             break;
         }
@@ -311,19 +559,10 @@ void DMenuContent::selectPrevious()
 
 void DMenuContent::selectNext()
 {
-    DDockMenu *parent = qobject_cast<DDockMenu*>(this->parent());
-    Q_ASSERT(parent);
+    for (int i = currentIndex() + 1; i < rowCount(); i++) {
+        const int item = modelIndex(i);
 
-    for (int i = currentIndex() + 1; i < actions().count(); i++) {
-        QAction * action = actions().at(i);
-
-        QString itemId(action->property("itemId").toString());
-
-        QString prop("%1Active");
-        QVariant activeCache = parent->getRootMenu()->property(prop.arg(itemId).toLatin1());
-        bool active = activeCache.isNull() ? action->isEnabled() : activeCache.toBool();
-
-        if (active && !action->text().isEmpty()) {
+        if (_model->isActive(item) && !_model->isSeparator(item)) {
             setCurrentIndex(i);
             break;
         }
@@ -332,29 +571,20 @@ void DMenuContent::selectNext()
 
 void DMenuContent::doCheck(int index) {
 
-    DDockMenu *parent = qobject_cast<DDockMenu*>(this->parent());
-    Q_ASSERT(parent);
+    const int item = modelIndex(index);
+    QString itemId = _model->itemId(item);
 
-    QAction *action = this->actions().at(index);
-    QString itemId = action->property("itemId").toString();
-    parent->getRootMenu()->setItemChecked(itemId, true);
+    _model->setChecked(item, true);
     this->sendItemClickedSignal(itemId, true);
 
-    if (Utils::menuItemCheckableFromId(itemId)) {
-        QStringList components = itemId.split(':');
-        QString group = components.at(0);
+    // radio exclusivity only needs to look at the members of the group.
+    const int group = _model->group(item);
+    if (group >= 0) {
+        for (int i = 0; i < _model->groupSize(group); i++) {
+            const int other = _model->groupMember(group, i);
 
-        foreach (QAction *act, this->actions()) {
-            QString _itemId = act->property("itemId").toString();
-
-            if (act != action && Utils::menuItemCheckableFromId(_itemId)) {
-                QStringList _components = _itemId.split(':');
-                QString _group = _components.at(0);
-                QString _type = _components.at(1);
-
-                if (_type == "radio" && _group == group) {
-                    parent->getRootMenu()->setItemChecked(_itemId, false);
-                }
+            if (other != item && _model->isRadio(other)) {
+                _model->setChecked(other, false);
             }
         }
     }
@@ -364,54 +594,30 @@ void DMenuContent::doCheck(int index) {
 
 void DMenuContent::doUnCheck(int index)
 {
-    DDockMenu *parent = qobject_cast<DDockMenu*>(this->parent());
-    Q_ASSERT(parent);
+    const int item = modelIndex(index);
+    QString itemId = _model->itemId(item);
 
-    QAction *action = this->actions().at(index);
-    QString itemId = action->property("itemId").toString();
+    bool checked = false;
 
-    if (Utils::menuItemCheckableFromId(itemId)) {
-        QStringList components = itemId.split(':');
-        QString group = components.at(0);
-        QString type = components.at(1);
+    if (_model->isRadio(item)) {
+        // a radio item can't be unchecked if it's the only checked one of its group.
+        bool hasNoCheck = true;
 
-        if (type == "radio") {
-            bool hasNoCheck = true;
+        const int group = _model->group(item);
+        for (int i = 0; i < _model->groupSize(group); i++) {
+            const int other = _model->groupMember(group, i);
 
-            foreach (QAction *act, this->actions()) {
-                QString _itemId = act->property("itemId").toString();
-
-                if (Utils::menuItemCheckableFromId(_itemId) && _itemId != itemId) {
-                    QStringList components = _itemId.split(':');
-                    QString _group = components.at(0);
-                    QString _type = components.at(1);
-
-                    if (group == _group && _type == "radio") {
-                        QString prop("%1Checked");
-                        QVariant checkedCache = parent->getRootMenu()->property(prop.arg(_itemId).toLatin1());
-                        bool checked = checkedCache.isNull() ? act->isChecked() : checkedCache.toBool();
-
-                        hasNoCheck = hasNoCheck && !checked;
-                    }
-                }
-            }
-
-            if (!hasNoCheck) {
-                parent->getRootMenu()->setItemChecked(itemId, false);
-                this->sendItemClickedSignal(action->property("itemId").toString(), false);
-            } else {
-                parent->getRootMenu()->setItemChecked(itemId, true);
-                this->sendItemClickedSignal(action->property("itemId").toString(), true);
+            if (other != item && _model->isRadio(other)) {
+                hasNoCheck = hasNoCheck && !_model->isChecked(other);
             }
-        } else {
-            parent->getRootMenu()->setItemChecked(itemId, false);
-            this->sendItemClickedSignal(action->property("itemId").toString(), false);
         }
-    } else {
-        parent->getRootMenu()->setItemChecked(itemId, false);
-        this->sendItemClickedSignal(action->property("itemId").toString(), false);
+
+        checked = hasNoCheck;
     }
 
+    _model->setChecked(item, checked);
+    this->sendItemClickedSignal(itemId, checked);
+
     this->update();
 }
 
@@ -424,9 +630,13 @@ void DMenuContent::sendItemClickedSignal(QString id, bool checked)
             qDebug() << Q_FUNC_INFO << "itemClicked";
 
             // NOTE(sbw): ensure mouse/keyboard released before send itemClicked,
+            // the ungrabs are flushed so they reach the X server before a
+            // client reacting to the signal can grab by itself.
             root->releaseMouse();
             root->releaseFocus();
             root->releaseKeyboard();
+            Utils::flushX11();
+
             root->itemClicked(id, checked);
             break;
         } else {
@@ -445,16 +655,15 @@ int DMenuContent::itemIndexUnderEvent(QPoint point) const
 
     DDockMenu *menuUnderCursor = parent->menuUnderPoint(point);
     if (menuUnderCursor == parent) {
-        int previousHeight = (y() + TopBottomPadding);
+        // rows are laid out in local coordinates, the same way they are painted.
+        int previousHeight = TopBottomPadding;
 
         QFontMetrics fm(font());
-        for (int i = 0; i < this->actions().count(); i++) {
-            QAction *action = this->actions().at(i);
-
-            int itemHeight = action->text().isEmpty() ? SEPARATOR_HEIGHT
-                                                      : (fm.height() + MENU_ITEM_TOP_BOTTOM_PADDING * 2);
+        for (int i = 0; i < rowCount(); i++) {
+            int itemHeight = _model->isSeparator(modelIndex(i)) ? SEPARATOR_HEIGHT
+                                                                : (fm.height() + MENU_ITEM_TOP_BOTTOM_PADDING * 2);
 
-            QRect itemRect(x(), previousHeight, width(), itemHeight);
+            QRect itemRect(0, previousHeight, width(), itemHeight);
 
             if (itemRect.contains(lPoint)) {
                 return i;
@@ -466,14 +675,3 @@ int DMenuContent::itemIndexUnderEvent(QPoint point) const
 
     return -1;
 }
-
-QString DMenuContent::elideText(QString source, int maxWidth) const
-{
-    QFontMetrics metrics(font());
-
-    if (metrics.width(source) < maxWidth) {
-        return source;
-    } else {
-        return metrics.elidedText(source, Qt::ElideRight, maxWidth);
-    }
-}
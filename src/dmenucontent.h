@@ -21,10 +21,14 @@
 #define DMENUCONTENT_H
 
 #include <QWidget>
-#include <QAction>
+#include <QVector>
+#include <QRect>
+#include <QPixmap>
+#include <QImage>
 
-class QRect;
+class QPainter;
 class DDockMenu;
+class DMenuModel;
 class DMenuContent : public QWidget
 {
     Q_OBJECT
@@ -33,36 +37,74 @@ public:
 
     int contentWidth();
     int contentHeight();
+    void invalidateLayout();
 
     int currentIndex();
     void setCurrentIndex(int);
 
-    void clearActions();
+    void setModel(DMenuModel *model, int first, int count);
+    int itemCount() const;
     void doCurrentAction();
 
+    bool isFiltering() const;
+    void appendFilterText(const QString &text);
+    void removeFilterText();
+    void clearFilter();
+    void invalidateFilterIndex();
+
+    QImage renderToImage(qreal devicePixelRatio, int hoveredRow = -1);
+
 protected:
     void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
 
 private:
     friend class DDockMenu;
-    void processCursorMove(const QPoint &p);
+    bool processCursorMove(const QPoint &p);
     void processButtonClick(const QPoint &p);
 
 private:
+    // column widths of the items shown, measured once by updateLayout().
     int _iconWidth;
     int _shortcutWidth;
     int _subMenuIndicatorWidth;
+    int _textWidth;
+    QVector<int> _textWidths;
 
     int _currentIndex;
+    // rect of the current row, moves inside it need no hit-test.
+    QRect _currentRowRect;
+
+    DMenuModel *_model;
+    int _firstItem;
+    int _itemCount;
+    // measuring every item is expensive, done once per model. -1 while the
+    // columns need to be measured again.
+    int _contentWidth;
+
+    // case folded item texts, searched by the type-ahead filter.
+    QString _foldedTexts;
+    QVector<int> _foldedOffsets;
+    QString _filterText;
+    // rows left visible after each character of _filterText.
+    QVector<QVector<int>> _filterStack;
+
+    int rowCount() const;
+    int modelIndex(int) const;
+    void buildFilterIndex();
+    bool rowMatches(int row, const QString &filterText) const;
+    void filterChanged();
     QRect getRectOfActionAtIndex(int);
-    int getNextItemsHasShortcut(int, QString);
     void selectPrevious();
     void selectNext();
     void doCheck(int);
     void doUnCheck(int);
     void sendItemClickedSignal(QString, bool);
     int itemIndexUnderEvent(QPoint point) const;
-    QString elideText(QString source, int maxWidth) const;
+    void updateLayout();
+    int rightPadding() const;
+    int rowHeight(int index, const QFontMetrics &metrics) const;
+    void paint(QPainter *painter, int width, qreal devicePixelRatio, int hoveredRow);
+    QPixmap iconPixmap(int item, bool hovered, qreal ratio) const;
 };
 
 #endif // DMENUCONTENT_H
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QVector>
+
+#include "dmenulimits.h"
+
+static int limitFromEnvironment(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+
+    return ok && value > 0 ? value : defaultValue;
+}
+
+DMenuLimits::DMenuLimits()
+    : m_maxBytes(limitFromEnvironment("DEEPIN_MENU_MAX_BYTES", 4 * 1024 * 1024))
+    , m_maxItems(limitFromEnvironment("DEEPIN_MENU_MAX_ITEMS", 10000))
+    , m_maxDepth(limitFromEnvironment("DEEPIN_MENU_MAX_DEPTH", 16))
+    , m_maxTextLength(limitFromEnvironment("DEEPIN_MENU_MAX_TEXT", 1024))
+{
+
+}
+
+const DMenuLimits &DMenuLimits::instance()
+{
+    static const DMenuLimits limits;
+    return limits;
+}
+
+int DMenuLimits::maxBytes() const
+{
+    return m_maxBytes;
+}
+
+int DMenuLimits::maxItems() const
+{
+    return m_maxItems;
+}
+
+int DMenuLimits::maxDepth() const
+{
+    return m_maxDepth;
+}
+
+int DMenuLimits::maxTextLength() const
+{
+    return m_maxTextLength;
+}
+
+bool DMenuLimits::checkSize(int bytes, QString *error) const
+{
+    if (bytes <= m_maxBytes)
+        return true;
+
+    *error = QString("payload of %1 bytes exceeds %2").arg(bytes).arg(m_maxBytes);
+    return false;
+}
+
+/**
+ * @brief DMenuLimits::checkStructure scans JSON text before it's parsed,
+ * counting objects and nesting outside of strings. Trees far bigger or
+ * deeper than any allowed menu are rejected without building a
+ * QJsonDocument for them. The bounds are loose, checkItems() still checks
+ * the exact limits afterwards.
+ */
+bool DMenuLimits::checkStructure(const QByteArray &json, QString *error) const
+{
+    // a menu level nests three times: the item object, its itemSubMenu
+    // object and the items array in it, plus the request around the menu.
+    const int maxNesting = 3 * m_maxDepth + 3;
+    // one object per item and at most one more for its submenu.
+    const int maxObjects = 2 * m_maxItems + 2;
+
+    int nesting = 0;
+    int objects = 0;
+    bool inString = false;
+
+    const char *end = json.constData() + json.size();
+    for (const char *p = json.constData(); p < end; p++) {
+        if (inString) {
+            if (*p == '\\')
+                p++;
+            else if (*p == '"')
+                inString = false;
+            continue;
+        }
+
+        switch (*p) {
+        case '"':
+            inString = true;
+            break;
+        case '{':
+            objects++;
+            nesting++;
+            break;
+        case '[':
+            nesting++;
+            break;
+        case '}':
+        case ']':
+            nesting--;
+            break;
+        default:
+            break;
+        }
+
+        if (nesting > maxNesting) {
+            *error = QString("menu nesting exceeds %1 levels").arg(m_maxDepth);
+            return false;
+        }
+        if (objects > maxObjects) {
+            *error = QString("menu has more than %1 items").arg(m_maxItems);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DMenuLimits::checkText(const QString &text, QString *error) const
+{
+    if (text.size() <= m_maxTextLength)
+        return true;
+
+    *error = QString("text of %1 characters exceeds %2").arg(text.size()).arg(m_maxTextLength);
+    return false;
+}
+
+/**
+ * @brief DMenuLimits::checkItems walks the item tree without recursion
+ * and stops at the first item over a limit, so rejecting a huge or deeply
+ * nested tree costs no more than accepting the largest allowed one.
+ */
+bool DMenuLimits::checkItems(const QJsonArray &items, QString *error) const
+{
+    struct PendingMenu {
+        QJsonArray items;
+        int depth;
+    };
+
+    QVector<PendingMenu> pending;
+    pending.append(PendingMenu{items, 1});
+
+    int itemCount = 0;
+    while (!pending.isEmpty()) {
+        const PendingMenu menu = pending.takeLast();
+
+        if (menu.depth > m_maxDepth) {
+            *error = QString("menu nesting exceeds %1 levels").arg(m_maxDepth);
+            return false;
+        }
+
+        itemCount += menu.items.size();
+        if (itemCount > m_maxItems) {
+            *error = QString("menu has more than %1 items").arg(m_maxItems);
+            return false;
+        }
+
+        for (const QJsonValue &value : menu.items) {
+            const QJsonObject itemObj = value.toObject();
+
+            if (!checkText(itemObj["itemText"].toString(), error)
+                    || !checkText(itemObj["itemId"].toString(), error)
+                    || !checkText(itemObj["itemExtra"].toString(), error))
+                return false;
+
+            const QJsonArray subItems = itemObj["itemSubMenu"].toObject()["items"].toArray();
+            if (!subItems.isEmpty())
+                pending.append(PendingMenu{subItems, menu.depth + 1});
+        }
+    }
+
+    return true;
+}
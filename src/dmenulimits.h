@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DMENULIMITS_H
+#define DMENULIMITS_H
+
+#include <QString>
+
+class QByteArray;
+class QJsonArray;
+
+/**
+ * @brief DMenuLimits bounds what a single client may ask the service to
+ * show, so one broken client can't stall or exhaust the menu service
+ * shared by the whole session.
+ *
+ * The defaults are far above any real menu and can be changed with
+ * DEEPIN_MENU_MAX_BYTES, DEEPIN_MENU_MAX_ITEMS, DEEPIN_MENU_MAX_DEPTH and
+ * DEEPIN_MENU_MAX_TEXT.
+ */
+class DMenuLimits
+{
+public:
+    static const DMenuLimits &instance();
+
+    int maxBytes() const;
+    int maxItems() const;
+    int maxDepth() const;
+    int maxTextLength() const;
+
+    bool checkSize(int bytes, QString *error) const;
+    bool checkStructure(const QByteArray &json, QString *error) const;
+    bool checkText(const QString &text, QString *error) const;
+    bool checkItems(const QJsonArray &items, QString *error) const;
+
+private:
+    DMenuLimits();
+
+    int m_maxBytes;
+    int m_maxItems;
+    int m_maxDepth;
+    int m_maxTextLength;
+};
+
+#endif // DMENULIMITS_H
@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QRegExp>
+
+#include "dmenumodel.h"
+
+static const char *IconKeys[] = { "itemIcon", "itemIconHover", "itemIconInactive" };
+
+DMenuModel::DMenuModel()
+    : m_rootCount(0)
+{
+
+}
+
+void DMenuModel::build(const QJsonArray &items)
+{
+    clear();
+
+    struct PendingMenu {
+        QJsonArray items;
+        int parent;
+    };
+
+    // first pass: walk the tree breadth first to collect every (sub)menu
+    // together with its parent item, and count items and characters so
+    // the columns and the string pool can be allocated exactly once.
+    QVector<PendingMenu> menus;
+    menus.append(PendingMenu{items, -1});
+
+    int itemCount = 0;
+    int charCount = 0;
+    for (int i = 0; i < menus.size(); i++) {
+        const QJsonArray array = menus.at(i).items;
+
+        for (const QJsonValue &value : array) {
+            const QJsonObject itemObj = value.toObject();
+
+            charCount += itemObj["itemId"].toString().size();
+            charCount += itemObj["itemText"].toString().size();
+            charCount += itemObj["itemExtra"].toString().size();
+            for (const char *key : IconKeys)
+                charCount += itemObj[key].toString().size();
+
+            const QJsonArray subItems = itemObj["itemSubMenu"].toObject()["items"].toArray();
+            if (!subItems.isEmpty())
+                menus.append(PendingMenu{subItems, itemCount});
+
+            itemCount++;
+        }
+    }
+
+    m_pool.reserve(charCount);
+    m_ids.reserve(itemCount);
+    m_texts.reserve(itemCount);
+    m_extras.reserve(itemCount);
+    for (QVector<Span> &icons : m_icons)
+        icons.reserve(itemCount);
+    m_flags.reserve(itemCount);
+    m_parent.reserve(itemCount);
+    m_group.reserve(itemCount);
+    m_childBegin.fill(-1, itemCount);
+    m_childCount.fill(0, itemCount);
+    m_idIndex.reserve(itemCount);
+
+    // second pass: every pending menu appends its items contiguously, which
+    // is what makes submenus plain index ranges.
+    QRegExp mnemonicRegExp("\\([^)]+\\)");
+    QHash<QPair<int, QStringRef>, int> groupIds;
+    for (const PendingMenu &menu : menus) {
+        const int begin = m_flags.size();
+
+        if (menu.parent < 0) {
+            m_rootCount = menu.items.size();
+        } else {
+            m_childBegin[menu.parent] = begin;
+            m_childCount[menu.parent] = menu.items.size();
+        }
+
+        for (const QJsonValue &value : menu.items) {
+            const QJsonObject itemObj = value.toObject();
+            const QString itemId = itemObj["itemId"].toString();
+            const QString itemText = itemObj["itemText"].toString().remove('_').remove(mnemonicRegExp);
+
+            const Span idSpan = store(itemId);
+
+            // "group:type:name", exactly two separators.
+            const int typeBegin = itemId.indexOf(':') + 1;
+            const int nameBegin = typeBegin > 0 ? itemId.indexOf(':', typeBegin) + 1 : 0;
+            const bool hasGroup = nameBegin > 0 && itemId.indexOf(':', nameBegin) < 0;
+
+            quint8 flags = 0;
+            if (itemObj["isActive"].toBool())
+                flags |= Active;
+            if (itemObj["isCheckable"].toBool() || hasGroup)
+                flags |= Checkable;
+            if (itemObj["checked"].toBool())
+                flags |= Checked;
+            if (itemText.isEmpty())
+                flags |= Separator;
+
+            int group = -1;
+            if (hasGroup) {
+                const QStringRef type(&m_pool, idSpan.offset + typeBegin, nameBegin - typeBegin - 1);
+                if (type == QLatin1String("radio"))
+                    flags |= Radio;
+
+                const QPair<int, QStringRef> key(menu.parent, QStringRef(&m_pool, idSpan.offset, typeBegin - 1));
+                group = groupIds.value(key, -1);
+                if (group < 0) {
+                    group = groupIds.size();
+                    groupIds.insert(key, group);
+                }
+            }
+
+            m_ids.append(idSpan);
+            m_texts.append(store(itemText));
+            m_extras.append(store(itemObj["itemExtra"].toString()));
+            for (int state = IconNormal; state < IconStateCount; state++)
+                m_icons[state].append(store(itemObj[IconKeys[state]].toString()));
+            m_flags.append(flags);
+            m_parent.append(menu.parent);
+            m_group.append(group);
+
+            if (!itemId.isEmpty())
+                m_idIndex.insert(QStringRef(&m_pool, idSpan.offset, idSpan.length), m_flags.size() - 1);
+        }
+    }
+
+    // lay the group members out next to each other, counting sort by group.
+    m_groupBegin.fill(0, groupIds.size() + 1);
+    for (int group : m_group)
+        if (group >= 0)
+            m_groupBegin[group + 1]++;
+    for (int group = 0; group < groupIds.size(); group++)
+        m_groupBegin[group + 1] += m_groupBegin[group];
+
+    m_groupMembers.resize(m_groupBegin.last());
+    QVector<int> cursor(m_groupBegin);
+    for (int item = 0; item < m_group.size(); item++)
+        if (m_group.at(item) >= 0)
+            m_groupMembers[cursor[m_group.at(item)]++] = item;
+}
+
+void DMenuModel::clear()
+{
+    m_pool = QString();
+    m_rootCount = 0;
+
+    m_ids = QVector<Span>();
+    m_texts = QVector<Span>();
+    m_extras = QVector<Span>();
+    for (QVector<Span> &icons : m_icons)
+        icons = QVector<Span>();
+    m_flags = QVector<quint8>();
+    m_parent = QVector<int>();
+    m_childBegin = QVector<int>();
+    m_childCount = QVector<int>();
+    m_group = QVector<int>();
+    m_groupBegin = QVector<int>();
+    m_groupMembers = QVector<int>();
+
+    m_idIndex = QHash<QStringRef, int>();
+    m_textOverrides = QHash<int, QString>();
+}
+
+int DMenuModel::count() const
+{
+    return m_flags.size();
+}
+
+int DMenuModel::rootCount() const
+{
+    return m_rootCount;
+}
+
+int DMenuModel::parentIndex(int index) const
+{
+    return m_parent.at(index);
+}
+
+int DMenuModel::childBegin(int index) const
+{
+    return m_childBegin.at(index);
+}
+
+int DMenuModel::childCount(int index) const
+{
+    return m_childCount.at(index);
+}
+
+bool DMenuModel::hasSubMenu(int index) const
+{
+    return m_childCount.at(index) != 0;
+}
+
+int DMenuModel::indexOf(const QString &itemId) const
+{
+    return m_idIndex.value(QStringRef(&itemId), -1);
+}
+
+QString DMenuModel::itemId(int index) const
+{
+    const Span &span = m_ids.at(index);
+    return m_pool.mid(span.offset, span.length);
+}
+
+QString DMenuModel::icon(int index, IconState state) const
+{
+    const Span &span = m_icons[state].at(index);
+    return m_pool.mid(span.offset, span.length);
+}
+
+QString DMenuModel::text(int index) const
+{
+    if (!m_textOverrides.isEmpty()) {
+        const auto it = m_textOverrides.constFind(index);
+        if (it != m_textOverrides.constEnd())
+            return it.value();
+    }
+
+    return string(m_texts.at(index));
+}
+
+QString DMenuModel::extra(int index) const
+{
+    return string(m_extras.at(index));
+}
+
+bool DMenuModel::isSeparator(int index) const
+{
+    return testFlag(index, Separator);
+}
+
+bool DMenuModel::isActive(int index) const
+{
+    return testFlag(index, Active);
+}
+
+bool DMenuModel::isCheckable(int index) const
+{
+    return testFlag(index, Checkable);
+}
+
+bool DMenuModel::isChecked(int index) const
+{
+    return testFlag(index, Checked);
+}
+
+bool DMenuModel::isRadio(int index) const
+{
+    return testFlag(index, Radio);
+}
+
+int DMenuModel::group(int index) const
+{
+    return m_group.at(index);
+}
+
+int DMenuModel::groupSize(int group) const
+{
+    return m_groupBegin.at(group + 1) - m_groupBegin.at(group);
+}
+
+int DMenuModel::groupMember(int group, int i) const
+{
+    return m_groupMembers.at(m_groupBegin.at(group) + i);
+}
+
+void DMenuModel::setActive(int index, bool active)
+{
+    setFlag(index, Active, active);
+}
+
+void DMenuModel::setChecked(int index, bool checked)
+{
+    setFlag(index, Checked, checked);
+}
+
+void DMenuModel::setText(int index, const QString &text)
+{
+    // kept beside the pool, which isn't touched after build() so the views
+    // text() handed out before stay valid.
+    m_textOverrides[index] = text;
+}
+
+DMenuModel::Span DMenuModel::store(const QString &str)
+{
+    const Span span{m_pool.size(), str.size()};
+    m_pool.append(str);
+
+    return span;
+}
+
+QString DMenuModel::string(const Span &span) const
+{
+    if (span.length == 0)
+        return QString();
+
+    return QString::fromRawData(m_pool.constData() + span.offset, span.length);
+}
+
+bool DMenuModel::testFlag(int index, ItemFlag flag) const
+{
+    return m_flags.at(index) & flag;
+}
+
+void DMenuModel::setFlag(int index, ItemFlag flag, bool on)
+{
+    if (on)
+        m_flags[index] |= flag;
+    else
+        m_flags[index] &= ~flag;
+}
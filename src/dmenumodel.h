@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DMENUMODEL_H
+#define DMENUMODEL_H
+
+#include <QString>
+#include <QStringRef>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+
+class QJsonArray;
+
+/**
+ * @brief DMenuModel stores a whole menu tree as flat, index based columns.
+ *
+ * Items of one (sub)menu are stored next to each other, so a submenu is
+ * just the range [childBegin, childBegin + childCount) of its parent item,
+ * and the root menu is always [0, rootCount). All strings are kept in a
+ * single pool, every column is allocated once per build and the whole
+ * model is released in one go by clear() or when its owner goes away.
+ */
+class DMenuModel
+{
+public:
+    enum IconState {
+        IconNormal,
+        IconHover,
+        IconInactive,
+        IconStateCount
+    };
+
+    DMenuModel();
+
+    void build(const QJsonArray &items);
+    void clear();
+
+    int count() const;
+    int rootCount() const;
+
+    int parentIndex(int index) const;
+    int childBegin(int index) const;
+    int childCount(int index) const;
+    bool hasSubMenu(int index) const;
+
+    int indexOf(const QString &itemId) const;
+
+    QString itemId(int index) const;
+    QString icon(int index, IconState state) const;
+
+    // NOTE: the returned string points into the string pool without copying
+    // it, so it's only valid until the model is built again or cleared. Copy
+    // it before storing it anywhere.
+    QString text(int index) const;
+    // the shortcut shown right aligned next to the text, same as text().
+    QString extra(int index) const;
+
+    bool isSeparator(int index) const;
+    bool isActive(int index) const;
+    bool isCheckable(int index) const;
+    bool isChecked(int index) const;
+
+    // item ids like "group:radio:name" or "group:checkbox:name" are parsed
+    // once while building, items sharing a group within the same menu can
+    // then be found without touching any string.
+    bool isRadio(int index) const;
+    int group(int index) const;
+    int groupSize(int group) const;
+    int groupMember(int group, int i) const;
+
+    // a model is built by one thread and only used by the GUI thread once
+    // it's handed over, the setters are never called concurrently with
+    // reads. Only flags are written in place, texts go to an override table.
+    void setActive(int index, bool active);
+    void setChecked(int index, bool checked);
+    void setText(int index, const QString &text);
+
+private:
+    Q_DISABLE_COPY(DMenuModel)
+
+    enum ItemFlag {
+        Active      = 0x1,
+        Checkable   = 0x2,
+        Checked     = 0x4,
+        Separator   = 0x8,
+        Radio       = 0x10
+    };
+
+    struct Span {
+        int offset;
+        int length;
+    };
+
+    Span store(const QString &str);
+    QString string(const Span &span) const;
+    bool testFlag(int index, ItemFlag flag) const;
+    void setFlag(int index, ItemFlag flag, bool on);
+
+    QString m_pool;
+    int m_rootCount;
+
+    QVector<Span> m_ids;
+    QVector<Span> m_texts;
+    QVector<Span> m_extras;
+    QVector<Span> m_icons[IconStateCount];
+    QVector<quint8> m_flags;
+    QVector<int> m_parent;
+    QVector<int> m_childBegin;
+    QVector<int> m_childCount;
+    QVector<int> m_group;
+
+    // members of group g are m_groupMembers[m_groupBegin[g], m_groupBegin[g + 1]).
+    QVector<int> m_groupBegin;
+    QVector<int> m_groupMembers;
+
+    QHash<QStringRef, int> m_idIndex;
+    // texts changed by setText(), the pool is only written by build().
+    QHash<int, QString> m_textOverrides;
+};
+
+#endif // DMENUMODEL_H
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QEvent>
+#include <QTimer>
+#include <QWidget>
+
+#include "dmenutrace.h"
+
+DMenuTrace::DMenuTrace(QObject *parent)
+    : QObject(parent)
+    , m_lastMark(0)
+    , m_painted(false)
+{
+    m_received.start();
+}
+
+QString DMenuTrace::traceId() const
+{
+    return m_traceId;
+}
+
+void DMenuTrace::setTraceId(const QString &traceId)
+{
+    m_traceId = traceId;
+}
+
+void DMenuTrace::setTriggerTime(qint64 msecs)
+{
+    if (m_received.clockType() != QElapsedTimer::MonotonicClock)
+        return;
+
+    // X event times are the low 32 bits of that clock and wrap every
+    // ~49.7 days, so compare them modulo 2^32.
+    const quint32 elapsed = quint32(m_received.msecsSinceReference()) - quint32(msecs);
+    // a trigger from the future wraps to a huge value as well; neither it
+    // nor one older than a minute is the click that opened this menu.
+    if (elapsed > MaxTriggerAge)
+        return;
+    m_timings["sinceTrigger"] = qint64(elapsed) * 1000;
+}
+
+void DMenuTrace::mark(const QString &phase)
+{
+    const qint64 now = m_received.nsecsElapsed() / 1000;
+
+    m_timings[phase] = now - m_lastMark;
+    m_lastMark = now;
+}
+
+/**
+ * @brief DMenuTrace::watch follows menu until its first frame was painted,
+ * then reports the trace through finished().
+ */
+void DMenuTrace::watch(QWidget *menu)
+{
+    menu->installEventFilter(this);
+}
+
+bool DMenuTrace::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::Show:
+        mark("map");
+        break;
+    case QEvent::Paint:
+        if (!m_painted) {
+            m_painted = true;
+            // the frame is flushed once the paint event returned.
+            QTimer::singleShot(0, this, &DMenuTrace::finish);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void DMenuTrace::finish()
+{
+    mark("firstPaint");
+
+    m_timings["total"] = m_lastMark;
+    if (m_timings.contains("sinceTrigger"))
+        m_timings["triggerToPaint"] = m_timings["sinceTrigger"].toLongLong() + m_lastMark;
+
+    emit finished(m_traceId, m_timings);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DMENUTRACE_H
+#define DMENUTRACE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QVariantMap>
+
+class QWidget;
+
+/**
+ * @brief DMenuTrace times one traced ShowMenu request from its arrival
+ * until the first frame of the menu is on screen.
+ *
+ * Every phase is marked with the microseconds spent since the previous
+ * mark. mark() may be called from the worker preparing the menu, as long
+ * as the trace isn't handed back to the GUI thread before. A trigger time
+ * in milliseconds of CLOCK_MONOTONIC, which is what X event times are on
+ * Xorg, adds the time spent before the request reached us. It is compared
+ * modulo 2^32, and dropped when it isn't within the last minute.
+ */
+class DMenuTrace : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DMenuTrace(QObject *parent = nullptr);
+
+    QString traceId() const;
+    void setTraceId(const QString &traceId);
+    void setTriggerTime(qint64 msecs);
+
+    void mark(const QString &phase);
+    void watch(QWidget *menu);
+
+signals:
+    void finished(const QString &traceId, const QVariantMap &timings);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
+
+private:
+    static const quint32 MaxTriggerAge = 60 * 1000;
+
+    void finish();
+
+    QString m_traceId;
+    QElapsedTimer m_received;
+    qint64 m_lastMark;
+    QVariantMap m_timings;
+    bool m_painted;
+};
+
+#endif // DMENUTRACE_H
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QDebug>
+
+#include "drendertier.h"
+
+// painting a menu frame should leave room in a 60Hz frame.
+static const qint64 PaintBudget = 8 * 1000 * 1000;
+// paints needed before the average is trusted, the first ones pay for
+// font and icon loading.
+static const int PaintWarmUp = 4;
+
+DRenderTier::DRenderTier(QObject *parent)
+    : QObject(parent)
+    , m_wmHelper(DWindowManagerHelper::instance())
+    , m_tier(FullTier)
+    , m_forced(false)
+    , m_softwareRendering(false)
+    , m_overBudget(false)
+    , m_paintCount(0)
+    , m_averagePaintTime(0)
+{
+    const QByteArray forcedTier = qgetenv("DEEPIN_MENU_RENDER_TIER");
+    if (forcedTier == "full" || forcedTier == "low") {
+        m_forced = true;
+        m_tier = forcedTier == "low" ? LowCostTier : FullTier;
+        return;
+    }
+
+    m_softwareRendering = qEnvironmentVariableIsSet("LIBGL_ALWAYS_SOFTWARE")
+            || qEnvironmentVariableIsSet("QT_XCB_FORCE_SOFTWARE_OPENGL")
+            || QCoreApplication::testAttribute(Qt::AA_UseSoftwareOpenGL);
+
+    connect(m_wmHelper, &DWindowManagerHelper::hasCompositeChanged, this, &DRenderTier::update);
+
+    update();
+}
+
+DRenderTier *DRenderTier::instance()
+{
+    static DRenderTier *renderTier = new DRenderTier(qApp);
+    return renderTier;
+}
+
+DRenderTier::Tier DRenderTier::tier() const
+{
+    return m_tier;
+}
+
+bool DRenderTier::isLowCost() const
+{
+    return m_tier == LowCostTier;
+}
+
+/**
+ * @brief DRenderTier::reportPaintTime feeds the time one menu frame took
+ * to paint into a moving average, which decides whether menus are over
+ * budget.
+ */
+void DRenderTier::reportPaintTime(qint64 nsecs)
+{
+    m_paintCount++;
+    m_averagePaintTime = m_paintCount == 1 ? nsecs : (m_averagePaintTime * 3 + nsecs) / 4;
+
+    if (m_forced || m_overBudget || m_paintCount < PaintWarmUp)
+        return;
+
+    if (m_averagePaintTime > PaintBudget) {
+        qDebug() << "menu frame time" << m_averagePaintTime / 1000 << "us is over budget, use low cost rendering";
+        m_overBudget = true;
+        update();
+    }
+}
+
+qint64 DRenderTier::averagePaintTime() const
+{
+    return m_averagePaintTime;
+}
+
+void DRenderTier::update()
+{
+    if (m_forced)
+        return;
+
+    const Tier tier = (!m_wmHelper->hasComposite() || m_softwareRendering || m_overBudget) ? LowCostTier : FullTier;
+    if (tier == m_tier)
+        return;
+
+    m_tier = tier;
+    emit tierChanged(m_tier);
+}
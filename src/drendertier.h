@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DRENDERTIER_H
+#define DRENDERTIER_H
+
+#include <QObject>
+
+#include <DWindowManagerHelper>
+
+DGUI_USE_NAMESPACE
+
+/**
+ * @brief DRenderTier decides how much effort menus put into their looks.
+ *
+ * Blur, translucency and shadows all need offscreen passes. Menus drop
+ * them and are painted opaque when there is no compositor, when the
+ * system renders in software, or once menu frames took longer than the
+ * budget on average. Being over budget sticks for the life of the
+ * process, the machine isn't going to get faster.
+ *
+ * DEEPIN_MENU_RENDER_TIER=full|low overrides the detection.
+ */
+class DRenderTier : public QObject
+{
+    Q_OBJECT
+public:
+    enum Tier {
+        FullTier,
+        LowCostTier
+    };
+
+    static DRenderTier *instance();
+
+    Tier tier() const;
+    bool isLowCost() const;
+
+    void reportPaintTime(qint64 nsecs);
+    qint64 averagePaintTime() const;
+
+signals:
+    void tierChanged(Tier tier);
+
+private:
+    explicit DRenderTier(QObject *parent = nullptr);
+
+    void update();
+
+    DWindowManagerHelper *m_wmHelper;
+    Tier m_tier;
+    bool m_forced;
+    bool m_softwareRendering;
+    bool m_overBudget;
+
+    int m_paintCount;
+    qint64 m_averagePaintTime;
+};
+
+#endif // DRENDERTIER_H
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QGuiApplication>
+#include <QScreen>
+#include <qpa/qplatformscreen.h>
+
+#include <climits>
+
+#include "dscreentopology.h"
+
+DScreenTopology::DScreenTopology(QObject *parent)
+    : QObject(parent)
+    , m_lastHit(0)
+{
+    connect(qApp, &QGuiApplication::screenAdded, this, [this] (QScreen *screen) {
+        watchScreen(screen);
+        refresh();
+    });
+    connect(qApp, &QGuiApplication::screenRemoved, this, [this] (QScreen *screen) {
+        // depending on the Qt version the screen may still be listed.
+        refresh(screen);
+    });
+
+    for (QScreen *screen : qApp->screens())
+        watchScreen(screen);
+
+    refresh();
+}
+
+DScreenTopology *DScreenTopology::instance()
+{
+    static DScreenTopology *topology = new DScreenTopology(qApp);
+    return topology;
+}
+
+int DScreenTopology::count() const
+{
+    return m_screens.size();
+}
+
+const DScreenTopology::Screen &DScreenTopology::screenAt(const QPoint &point) const
+{
+    static const Screen noScreen = Screen{nullptr, QRect(), QRect(), QRect(), 1.0};
+
+    const int index = lookup(point, &Screen::geometry);
+    return index < 0 ? noScreen : m_screens.at(index);
+}
+
+const DScreenTopology::Screen &DScreenTopology::screenAtNative(const QPoint &point) const
+{
+    static const Screen noScreen = Screen{nullptr, QRect(), QRect(), QRect(), 1.0};
+
+    const int index = lookup(point, &Screen::nativeGeometry);
+    return index < 0 ? noScreen : m_screens.at(index);
+}
+
+/**
+ * @brief DScreenTopology::clamp
+ * @return the top left position rect has to be moved to so that it fits
+ * into bounds, it sticks to the top left edge if it's larger than bounds.
+ */
+QPoint DScreenTopology::clamp(const QRect &rect, const QRect &bounds)
+{
+    int x = qMin(rect.x(), bounds.right() + 1 - rect.width());
+    int y = qMin(rect.y(), bounds.bottom() + 1 - rect.height());
+
+    return QPoint(qMax(x, bounds.left()), qMax(y, bounds.top()));
+}
+
+void DScreenTopology::watchScreen(QScreen *screen)
+{
+    connect(screen, &QScreen::geometryChanged, this, [this] { refresh(); });
+    connect(screen, &QScreen::availableGeometryChanged, this, [this] { refresh(); });
+}
+
+void DScreenTopology::refresh(QScreen *removed)
+{
+    m_screens.clear();
+    m_lastHit = 0;
+
+    for (QScreen *screen : qApp->screens()) {
+        if (screen == removed)
+            continue;
+
+        m_screens.append(Screen{screen,
+                                screen->handle()->geometry(),
+                                screen->geometry(),
+                                screen->availableGeometry(),
+                                screen->devicePixelRatio()});
+    }
+}
+
+/**
+ * @brief DScreenTopology::lookup finds the screen containing point.
+ *
+ * There are a handful of screens at most, a scan over their rects starting
+ * with the last hit beats any tree here.
+ */
+int DScreenTopology::lookup(const QPoint &point, QRect Screen::*geometry) const
+{
+    if (m_screens.isEmpty())
+        return -1;
+
+    if ((m_screens.at(m_lastHit).*geometry).contains(point))
+        return m_lastHit;
+
+    int nearest = 0;
+    int nearestDistance = INT_MAX;
+    for (int i = 0; i < m_screens.size(); i++) {
+        const QRect &rect = m_screens.at(i).*geometry;
+        if (rect.contains(point)) {
+            m_lastHit = i;
+            return i;
+        }
+
+        const int dx = qMax(rect.left() - point.x(), qMax(0, point.x() - rect.right()));
+        const int dy = qMax(rect.top() - point.y(), qMax(0, point.y() - rect.bottom()));
+        if (dx + dy < nearestDistance) {
+            nearestDistance = dx + dy;
+            nearest = i;
+        }
+    }
+
+    return nearest;
+}
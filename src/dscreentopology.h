@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DSCREENTOPOLOGY_H
+#define DSCREENTOPOLOGY_H
+
+#include <QObject>
+#include <QRect>
+#include <QVector>
+
+class QScreen;
+
+/**
+ * @brief DScreenTopology keeps the geometry of all screens at hand.
+ *
+ * Screens are read from the platform once and again only when one is
+ * added, removed or changes its geometry, so placing a menu is a lookup
+ * in a few cached rects instead of a round of platform calls.
+ */
+class DScreenTopology : public QObject
+{
+    Q_OBJECT
+public:
+    struct Screen {
+        QScreen *screen;
+        // in device pixels, as X and the dock report positions.
+        QRect nativeGeometry;
+        QRect geometry;
+        QRect availableGeometry;
+        qreal devicePixelRatio;
+    };
+
+    static DScreenTopology *instance();
+
+    int count() const;
+
+    // both fall back to the screen nearest to point if no screen has it.
+    const Screen &screenAt(const QPoint &point) const;
+    const Screen &screenAtNative(const QPoint &point) const;
+
+    static QPoint clamp(const QRect &rect, const QRect &bounds);
+
+private:
+    explicit DScreenTopology(QObject *parent = nullptr);
+
+    void watchScreen(QScreen *screen);
+    void refresh(QScreen *removed = nullptr);
+    int lookup(const QPoint &point, QRect Screen::*geometry) const;
+
+    QVector<Screen> m_screens;
+    // menus tend to show up on the same screen again and again.
+    mutable int m_lastHit;
+};
+
+#endif // DSCREENTOPOLOGY_H
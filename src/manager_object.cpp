@@ -24,36 +24,61 @@
 #include "dbus_menu_adaptor.h"
 #include "manager_object.h"
 
+static const int MenuPoolSize = 4;
+
 ManagerObject::ManagerObject(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    nextPooledMenu(0)
 {
     menuObjectPath = "";
     menuObject = nullptr;
-    menuAdaptor = nullptr;
+
+    for (int i = 0; i < MenuPoolSize; i++) {
+        QString uuid = QUuid::createUuid().toString();
+        uuid = uuid.replace("{", "");
+        uuid = uuid.replace("}", "");
+        uuid = uuid.replace("-", "_");
+
+        PooledMenu menu;
+        menu.object = new MenuObject;
+        menu.object->setParent(this);
+        menu.path = "/com/deepin/menu/" + uuid;
+        new MenuAdaptor(menu.object);
+        QDBusConnection::sessionBus().registerObject(menu.path, menu.object);
+
+        connect(menu.object, &MenuObject::recycled, this, &ManagerObject::menuObjectRecycledSlot);
+
+        menuPool << menu;
+    }
+}
+
+QStringList ManagerObject::features() const
+{
+    return QStringList() << FEATURE_INLINE_MENU_CONTENT << FEATURE_MENU_TRACE;
+}
+
+QVariantMap ManagerObject::statistics() const
+{
+    return MenuObject::statistics();
 }
 
+/**
+ * @brief ManagerObject::RegisterMenu checks out the next pooled menu object,
+ * no bus registration is involved. Calls to an object which was recycled
+ * since are rejected by its adaptor.
+ */
 QDBusObjectPath ManagerObject::RegisterMenu()
 {
     UnregisterMenu();
 
-    if (!menuAdaptor.isNull())
-        menuAdaptor->deleteLater();
-
     menuRegisterGuard.lock();
 
-    QString uuid = QUuid::createUuid().toString();
-    uuid = uuid.replace("{", "");
-    uuid = uuid.replace("}", "");
-    uuid = uuid.replace("-", "_");
-    menuObjectPath = "/com/deepin/menu/" + uuid;
-
-    menuObject = new MenuObject;
-    menuAdaptor = new MenuAdaptor(menuObject);
+    PooledMenu &menu = menuPool[nextPooledMenu];
+    nextPooledMenu = (nextPooledMenu + 1) % menuPool.size();
 
-    connect(menuObject.data(), &MenuObject::destroyed, this, &ManagerObject::menuObjectDestroiedSlot, Qt::QueuedConnection);
-
-    QDBusConnection connection = QDBusConnection::sessionBus();
-    connection.registerObject(menuObjectPath, menuObject);
+    menuObject = menu.object;
+    menuObjectPath = menu.path;
+    menuObject->checkout();
 
     QDBusObjectPath result(menuObjectPath);
 
@@ -74,24 +99,22 @@ void ManagerObject::UnregisterMenu(const QString &)
 
     menuRegisterGuard.lock();
 
-    if (!menuObject.isNull() || !menuObjectPath.isEmpty())
-    {
-        if (!menuObject.isNull())
-            delete menuObject;
-
-        menuObject.clear();
-        menuObjectPath.clear();
-    }
+    MenuObject *object = menuObject;
+    menuObject.clear();
+    menuObjectPath.clear();
 
     menuRegisterGuard.unlock();
+
+    if (object)
+        object->recycle();
 }
 
 // private slots
-void ManagerObject::menuObjectDestroiedSlot()
+void ManagerObject::menuObjectRecycledSlot()
 {
-    if (!menuObject.isNull())
-        menuObject->deleteLater();
+    if (sender() != menuObject.data())
+        return;
 
-    QDBusConnection connection = QDBusConnection::sessionBus();
-    connection.unregisterObject(menuObjectPath);
+    menuObject.clear();
+    menuObjectPath.clear();
 }
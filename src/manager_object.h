@@ -22,18 +22,32 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QDBusObjectPath>
 #include <QMutex>
+#include <QVector>
 
 #include <src/dbus_menu_adaptor.h>
 #include <src/menu_object.h>
 
+// menuJsonContent of ShowMenu may be passed as a JSON object instead of
+// a JSON encoded string, which saves clients and us a second encode/parse.
+#define FEATURE_INLINE_MENU_CONTENT "inline-menu-content"
+// ShowMenu takes an optional traceId and triggerTime, traced menus report
+// MenuShown with server side timings and ItemInvokedWithTrace.
+#define FEATURE_MENU_TRACE "menu-trace"
+
 class ManagerObject : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(QStringList Features READ features)
+    Q_PROPERTY(QVariantMap Statistics READ statistics)
 public:
     explicit ManagerObject(QObject *parent = 0);
 
+    QStringList features() const;
+    QVariantMap statistics() const;
+
 signals:
 
 public slots:
@@ -42,13 +56,23 @@ public slots:
     void UnregisterMenu(const QString &menuObjectPath);
 
 private:
+    struct PooledMenu {
+        MenuObject *object;
+        QString path;
+    };
+
     QMutex menuRegisterGuard;
     QPointer<MenuObject> menuObject;
-    QPointer<MenuAdaptor> menuAdaptor;
     QString menuObjectPath;
 
+    // menu objects and their adaptors are registered once and handed out
+    // round robin, a path stays idle for the other checkouts of the pool
+    // before it's handed out again.
+    QVector<PooledMenu> menuPool;
+    int nextPooledMenu;
+
 private slots:
-    void menuObjectDestroiedSlot();
+    void menuObjectRecycledSlot();
 };
 
 #endif // MANAGER_OBJECT_H
@@ -23,13 +23,71 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QtGlobal>
-#include <QStyle>
 #include <QDebug>
 #include <QScreen>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 
 #include "menu_object.h"
 #include "ddesktopmenu.h"
 #include "ddockmenu.h"
+#include "dmenumodel.h"
+#include "dmenulimits.h"
+#include "dmenutrace.h"
+
+// one per ShowMenu call, shared with the worker preparing it. A newer
+// ShowMenu or the menu object going away supersedes it, the worker then
+// stops at the next phase boundary.
+struct ShowGeneration {
+    explicit ShowGeneration(int id)
+        : id(id)
+        , trace(new DMenuTrace, &QObject::deleteLater)
+    {}
+
+    const int id;
+    QAtomicInt superseded;
+    // only reported if the request carried a trace id.
+    const QSharedPointer<DMenuTrace> trace;
+};
+
+enum ShowCounter {
+    ShowsRequested,
+    CancelledBeforeParse,
+    CancelledBeforeBuild,
+    CancelledBeforeShow,
+    ShowCounterCount
+};
+
+static const char *ShowCounterNames[] = {
+    "ShowsRequested", "CancelledBeforeParse", "CancelledBeforeBuild", "CancelledBeforeShow"
+};
+
+static QAtomicInt ShowCounters[ShowCounterCount];
+
+struct PreparedMenu {
+    // set if the generation was superseded before the menu was ready.
+    bool cancelled;
+    // empty unless the request was rejected.
+    QString error;
+    int x;
+    int y;
+    QString direction;
+    bool isDockMenu;
+    bool isScaled;
+    QJsonArray items;
+    QSharedPointer<DMenuModel> model;
+    QSharedPointer<ShowGeneration> generation;
+};
+
+static bool cancelIfSuperseded(PreparedMenu *menu, ShowCounter counter)
+{
+    if (!menu->generation->superseded.load())
+        return false;
+
+    ShowCounters[counter].ref();
+    menu->cancelled = true;
+    return true;
+}
 
 static DArrowRectangle::ArrowDirection DirectionFromString(QString direction) {
     if (direction == "top") {
@@ -45,101 +103,293 @@ static DArrowRectangle::ArrowDirection DirectionFromString(QString direction) {
 
 MenuObject::MenuObject():
     QObject(),
-    m_dockMenu(nullptr),
-    m_desktopMenu(nullptr)
+    m_menu(nullptr),
+    m_checkedOut(false),
+    m_pendingShows(0)
 {
 
 }
 
 MenuObject::~MenuObject()
 {
-    if (!m_dockMenu.isNull()) {
-        delete m_dockMenu;
+    if (m_generation)
+        m_generation->superseded.store(1);
+
+    if (!m_menu.isNull()) {
+        delete m_menu;
     }
+}
 
-    if (!m_desktopMenu.isNull()) {
-        delete m_desktopMenu;
+/**
+ * @brief MenuObject::checkout hands this pooled menu object to a client,
+ * calls are accepted until it's recycled.
+ */
+void MenuObject::checkout()
+{
+    m_checkedOut = true;
+}
+
+/**
+ * @brief MenuObject::recycle drops everything the last owner left behind,
+ * including shows still being prepared, so the object and its bus path
+ * can be handed out again.
+ */
+void MenuObject::recycle()
+{
+    if (m_generation) {
+        m_generation->superseded.store(1);
+        m_generation.clear();
     }
+
+    for (QFutureWatcherBase *watcher : findChildren<QFutureWatcherBase *>(QString(), Qt::FindDirectChildrenOnly)) {
+        watcher->disconnect(this);
+        watcher->deleteLater();
+    }
+    m_pendingShows = 0;
+    m_pendingUpdates.clear();
+
+    // queued dismissals of the old menu must not reach the next owner.
+    if (!m_menu.isNull()) {
+        m_menu->disconnect(this);
+        m_menu->deleteLater();
+        m_menu = nullptr;
+    }
+
+    m_checkedOut = false;
+
+    emit recycled();
+}
+
+bool MenuObject::isCheckedOut() const
+{
+    return m_checkedOut;
 }
 
 void MenuObject::SetItemActivity(const QString &itemId, bool isActive)
 {
-    if (!m_dockMenu.isNull()) m_dockMenu->setItemActivity(itemId, isActive);
-    if (!m_desktopMenu.isNull()) m_desktopMenu->setItemActivity(itemId, isActive);
+    if (m_pendingShows > 0) {
+        m_pendingUpdates << [=] { SetItemActivity(itemId, isActive); };
+        return;
+    }
+
+    if (!m_menu.isNull()) m_menu->setItemActivity(itemId, isActive);
 }
 
 void MenuObject::SetItemChecked(const QString &itemId, bool checked)
 {
-    if (!m_dockMenu.isNull()) m_dockMenu->setItemChecked(itemId, checked);
-    if (!m_desktopMenu.isNull()) m_desktopMenu->setItemChecked(itemId, checked);
+    if (m_pendingShows > 0) {
+        m_pendingUpdates << [=] { SetItemChecked(itemId, checked); };
+        return;
+    }
+
+    if (!m_menu.isNull()) m_menu->setItemChecked(itemId, checked);
 }
 
 void MenuObject::SetItemText(const QString &itemId, const QString &text)
 {
-    if (!m_dockMenu.isNull()) m_dockMenu->setItemText(itemId, text);
-    if (!m_desktopMenu.isNull()) m_desktopMenu->setItemText(itemId, text);
+    QString error;
+    if (!DMenuLimits::instance().checkText(text, &error)) {
+        qWarning() << "SetItemText rejected:" << error;
+        return;
+    }
+
+    if (m_pendingShows > 0) {
+        m_pendingUpdates << [=] { SetItemText(itemId, text); };
+        return;
+    }
+
+    if (!m_menu.isNull()) m_menu->setItemText(itemId, text);
 }
 
+/**
+ * @brief MenuObject::ShowMenu parses the request and builds the item model
+ * on a worker thread, the GUI thread only creates and shows the window, so
+ * menus already on screen keep handling input meanwhile. Item updates
+ * arriving before the menu is up are applied right after it shows.
+ */
 void MenuObject::ShowMenu(const QString &menuJsonContent)
 {
+    static int nextGeneration = 0;
+
+    ShowCounters[ShowsRequested].ref();
+
+    // only the latest request of this menu is worth finishing.
+    if (m_generation)
+        m_generation->superseded.store(1);
+    m_generation.reset(new ShowGeneration(++nextGeneration));
+
+    m_pendingShows++;
+
+    QFutureWatcher<PreparedMenu> *watcher = new QFutureWatcher<PreparedMenu>(this);
+    connect(watcher, &QFutureWatcher<PreparedMenu>::finished, this, [this, watcher] {
+        watcher->deleteLater();
+        m_pendingShows--;
+
+        showPreparedMenu(watcher->result());
+
+        if (m_pendingShows == 0) {
+            const QVector<std::function<void ()>> updates = m_pendingUpdates;
+            m_pendingUpdates.clear();
+            for (const std::function<void ()> &update : updates)
+                update();
+        }
+    });
+
+    watcher->setFuture(QtConcurrent::run(&MenuObject::prepareMenu, menuJsonContent, m_generation));
+}
+
+/**
+ * @brief MenuObject::statistics counts ShowMenu requests of all menus and
+ * how many of them were dropped at each phase because a newer request
+ * superseded them.
+ */
+QVariantMap MenuObject::statistics()
+{
+    QVariantMap statistics;
+    for (int counter = 0; counter < ShowCounterCount; counter++)
+        statistics[ShowCounterNames[counter]] = ShowCounters[counter].load();
+
+    return statistics;
+}
+
+// runs on a worker thread, must not touch any widget.
+PreparedMenu MenuObject::prepareMenu(const QString &menuJsonContent, const QSharedPointer<ShowGeneration> &generation)
+{
+    const DMenuLimits &limits = DMenuLimits::instance();
+    PreparedMenu menu;
+    menu.cancelled = false;
+    menu.generation = generation;
+
+    DMenuTrace *trace = generation->trace.data();
+    trace->mark("queue");
+
+    if (cancelIfSuperseded(&menu, CancelledBeforeParse))
+        return menu;
+
     QByteArray bytes;
     bytes.append(menuJsonContent);
+    if (!limits.checkSize(bytes.size(), &menu.error) || !limits.checkStructure(bytes, &menu.error))
+        return menu;
+
     QJsonDocument menuDocument = QJsonDocument::fromJson(bytes);
     QJsonObject jsonObj = menuDocument.object();
 
-    int x = jsonObj["x"].toDouble();
-    int y = jsonObj["y"].toDouble();
-    QString direction = jsonObj["direction"].toString();
+    menu.x = jsonObj["x"].toDouble();
+    menu.y = jsonObj["y"].toDouble();
+    menu.direction = jsonObj["direction"].toString();
+    menu.isDockMenu = jsonObj["isDockMenu"].toBool();
+    menu.isScaled = true;
+    if (!jsonObj["isScaled"].isNull()) {
+        menu.isScaled = jsonObj["isScaled"].toBool();
+    }
 
-    if(jsonObj["isDockMenu"].toBool()) {
-        m_dockMenu = new DDockMenu;
-        connect(m_dockMenu, &DDockMenu::destroyed, this, &MenuObject::menuDismissedSlot, Qt::QueuedConnection);
-        connect(m_dockMenu, &DDockMenu::itemClicked, this, &MenuObject::ItemInvoked);
-    } else {
-        m_desktopMenu = new DDesktopMenu;
-        connect(m_desktopMenu, &DDesktopMenu::aboutToHide, this, &MenuObject::menuDismissedSlot, Qt::QueuedConnection);
-        connect(m_desktopMenu, &DDesktopMenu::itemClicked, this, &MenuObject::ItemInvoked);
-    }
-
-    bytes.clear();
-    bytes.append(jsonObj["menuJsonContent"].toString());
-    QJsonDocument menuContent = QJsonDocument::fromJson(bytes);
-    QJsonObject menuContentObj = menuContent.object();
-
-    if (!m_dockMenu.isNull()) {
-        m_dockMenu->setArrowDirection(DirectionFromString(direction));
-        m_dockMenu->setItems(menuContentObj["items"].toArray());
-        m_dockMenu->show(x, y);
-    } else if (!m_desktopMenu.isNull()) {
-        m_desktopMenu->setItems(menuContentObj["items"].toArray());
-
-        // 在Qt 5.10.x上, 菜单 show 之前没有被polish, 导致 dstyle 中无法将菜单设置为"圆角+模糊"样式
-        if (m_desktopMenu->style() && !m_desktopMenu->testAttribute(Qt::WA_WState_Polished)) {
-            m_desktopMenu->style()->polish(m_desktopMenu);
-        }
+    trace->setTraceId(jsonObj["traceId"].toString());
+    if (jsonObj["triggerTime"].isDouble())
+        trace->setTriggerTime(jsonObj["triggerTime"].toDouble());
 
-        bool isScaled = true;
-        if (!jsonObj["isScaled"].isNull()) {
-            isScaled = jsonObj["isScaled"].toBool();
-        }
+    QJsonObject menuContentObj;
+    const QJsonValue menuContentValue = jsonObj["menuJsonContent"];
+    if (menuContentValue.isObject()) {
+        menuContentObj = menuContentValue.toObject();
+    } else {
+        bytes.clear();
+        bytes.append(menuContentValue.toString());
+        if (!limits.checkStructure(bytes, &menu.error))
+            return menu;
+        menuContentObj = QJsonDocument::fromJson(bytes).object();
+    }
+    menu.items = menuContentObj["items"].toArray();
 
-        m_desktopMenu->showMenu(QPoint(x, y), isScaled);
+    if (!limits.checkItems(menu.items, &menu.error)) {
+        menu.items = QJsonArray();
+        return menu;
     }
+
+    trace->mark("parse");
+
+    if (cancelIfSuperseded(&menu, CancelledBeforeBuild))
+        return menu;
+
+    menu.model.reset(new DMenuModel);
+    menu.model->build(menu.items);
+    trace->mark("build");
+
+    return menu;
 }
 
-void MenuObject::menuDismissedSlot()
+void MenuObject::showPreparedMenu(const PreparedMenu &menu)
 {
-    emit MenuUnregistered();
+    if (menu.cancelled || menu.generation->superseded.load()) {
+        if (!menu.cancelled)
+            ShowCounters[CancelledBeforeShow].ref();
+
+        qDebug() << "ShowMenu generation" << menu.generation->id << "superseded, dropped";
+        return;
+    }
 
-    if (!m_dockMenu.isNull()) {
-        m_dockMenu->deleteLater();
-        m_dockMenu = nullptr;
+    if (!menu.error.isEmpty()) {
+        qWarning() << "ShowMenu rejected:" << menu.error;
+        // tell the client the menu is gone, as if it was dismissed.
+        menuDismissedSlot();
+        return;
     }
 
-    if (!m_desktopMenu.isNull()) {
-        m_desktopMenu->deleteLater();
-        m_desktopMenu = nullptr;
+    // dismissals are queued and clicks may come from a menu on its way out,
+    // one of an older generation must not touch the current one.
+    const QSharedPointer<ShowGeneration> generation = menu.generation;
+    auto dismissed = [this, generation] {
+        if (generation == m_generation)
+            menuDismissedSlot();
+    };
+
+    DMenuTrace *trace = generation->trace.data();
+    trace->mark("dispatch");
+
+    // a menu still up from an earlier ShowMenu goes away first, its clicks
+    // must not be reported any more.
+    if (!m_menu.isNull()) {
+        disconnect(m_menu, nullptr, this, nullptr);
+        m_menu->destroyAll();
+    }
+
+    DDesktopMenu *desktopMenu = nullptr;
+    if (menu.isDockMenu) {
+        m_menu = new DDockMenu;
+        m_menu->setArrowDirection(DirectionFromString(menu.direction));
+    } else {
+        m_menu = desktopMenu = new DDesktopMenu;
+    }
+
+    connect(m_menu, &DDockMenu::destroyed, this, dismissed, Qt::QueuedConnection);
+    connect(m_menu, &DDockMenu::itemClicked, this, [this, generation] (const QString &itemId, bool checked) {
+        if (generation == m_generation)
+            itemInvokedSlot(itemId, checked);
+    });
+
+    if (!trace->traceId().isEmpty()) {
+        connect(trace, &DMenuTrace::finished, this, &MenuObject::MenuShown);
+        trace->watch(m_menu);
     }
 
-    deleteLater();
+    m_menu->setModel(menu.model);
+
+    if (desktopMenu)
+        desktopMenu->showMenu(QPoint(menu.x, menu.y), menu.isScaled);
+    else
+        m_menu->showAt(QPoint(menu.x, menu.y));
+}
+
+void MenuObject::itemInvokedSlot(const QString &itemId, bool checked)
+{
+    emit ItemInvoked(itemId, checked);
+
+    if (m_generation && !m_generation->trace->traceId().isEmpty())
+        emit ItemInvokedWithTrace(itemId, checked, m_generation->trace->traceId());
+}
+
+void MenuObject::menuDismissedSlot()
+{
+    emit MenuUnregistered();
+
+    recycle();
 }
@@ -22,9 +22,15 @@
 
 #include <QObject>
 #include <QPointer>
+#include <QVector>
+#include <QVariantMap>
+#include <QSharedPointer>
 
+#include <functional>
+
+struct PreparedMenu;
+struct ShowGeneration;
 class DDockMenu;
-class DDesktopMenu;
 class MenuObject : public QObject
 {
     Q_OBJECT
@@ -32,9 +38,20 @@ public:
     MenuObject();
     ~MenuObject();
 
+    static QVariantMap statistics();
+
+    void checkout();
+    void recycle();
+    bool isCheckedOut() const;
+
 signals:
     void ItemInvoked(const QString &itemId, bool checked);
     void MenuUnregistered();
+    // only for requests carrying a trace id, timings are in microseconds.
+    void MenuShown(const QString &traceId, const QVariantMap &timings);
+    void ItemInvokedWithTrace(const QString &itemId, bool checked, const QString &traceId);
+
+    void recycled();
 
 public slots:
     void SetItemActivity(const QString &itemId, bool isActive);
@@ -44,11 +61,21 @@ public slots:
     void ShowMenu(const QString &menuJsonContent);
 
 private slots:
+    void itemInvokedSlot(const QString &itemId, bool checked);
     void menuDismissedSlot();
 
 private:
-    QPointer<DDockMenu> m_dockMenu;
-    QPointer<DDesktopMenu> m_desktopMenu;
+    static PreparedMenu prepareMenu(const QString &menuJsonContent, const QSharedPointer<ShowGeneration> &generation);
+    void showPreparedMenu(const PreparedMenu &menu);
+
+    // the desktop menu is a dock menu with a different look.
+    QPointer<DDockMenu> m_menu;
+
+    bool m_checkedOut;
+
+    QSharedPointer<ShowGeneration> m_generation;
+    int m_pendingShows;
+    QVector<std::function<void ()>> m_pendingUpdates;
 };
 
 #endif // MENU_OBJECT_H
@@ -0,0 +1,67 @@
+#-------------------------------------------------
+#
+# Project created by QtCreator 2014-08-14T14:55:09
+#
+#-------------------------------------------------
+
+QT       += core gui dbus dtkwidget x11extras concurrent
+
+greaterThan(QT_MINOR_VERSION, 7): QT += gui-private
+else: QT += platformsupport-private
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = deepin-menu
+TEMPLATE = app
+
+CONFIG += c++11 link_pkgconfig
+PKGCONFIG += xcb
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += main.cpp \
+    ddesktopmenu.cpp \
+    utils.cpp \
+    dmenucontent.cpp \
+    dbus_manager_adaptor.cpp \
+    dbus_menu_adaptor.cpp \
+    manager_object.cpp \
+    menu_object.cpp \
+    ddockmenu.cpp \
+    dmenuapplication.cpp \
+    dabstractmenu.cpp \
+    dmenumodel.cpp \
+    dscreentopology.cpp \
+    drendertier.cpp \
+    ddecorationatlas.cpp \
+    dcallrecorder.cpp \
+    dmenulimits.cpp \
+    dmenutrace.cpp
+
+HEADERS  += \
+    ddesktopmenu.h \
+    utils.h \
+    dmenucontent.h \
+    dbus_manager_adaptor.h \
+    dbus_menu_adaptor.h \
+    manager_object.h \
+    menu_object.h \
+    ddockmenu.h \
+    dmenuapplication.h \
+    dabstractmenu.h \
+    dmenumodel.h \
+    dscreentopology.h \
+    drendertier.h \
+    ddecorationatlas.h \
+    dcallrecorder.h \
+    dmenulimits.h \
+    dmenutrace.h
+
+dbus.path = /usr/share/dbus-1/services
+dbus.files = ../data/com.deepin.menu.service
+
+RESOURCES += \
+    ../images.qrc
+
+target.path = /usr/bin
+INSTALLS += target dbus
@@ -17,13 +17,27 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QX11Info>
+
 #include "utils.h"
 
+#include <xcb/xcb.h>
+
 namespace Utils {
 
-bool menuItemCheckableFromId(QString id)
+bool menuItemCheckableFromId(const QString &id)
+{
+    return id.count(':') == 2;
+}
+
+/**
+ * @brief flushX11 sends the requests Qt queued on its X connection, like
+ * ungrabs, right away instead of when the event loop gets to it.
+ */
+void flushX11()
 {
-    return id.split(':').count() == 3;
+    if (QX11Info::isPlatformX11())
+        xcb_flush(QX11Info::connection());
 }
 
 }
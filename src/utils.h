@@ -33,7 +33,8 @@ class QString;
 
 namespace Utils {
 
-bool menuItemCheckableFromId(QString id);
+bool menuItemCheckableFromId(const QString &id);
+void flushX11();
 
 }
 
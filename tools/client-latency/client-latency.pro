@@ -0,0 +1,13 @@
+QT       += core dbus
+QT       -= gui
+
+TARGET = deepin-menu-client-latency
+TEMPLATE = app
+
+CONFIG += c++11 console link_pkgconfig
+PKGCONFIG += x11 xtst
+
+INCLUDEPATH += $$PWD/../../client
+LIBS += -L$$OUT_PWD/../../client -ldeepin-menu-client
+
+SOURCES += main.cpp
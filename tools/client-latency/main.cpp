@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include <QDebug>
+
+#include <algorithm>
+#include <cstdio>
+
+#include "dmenuclient.h"
+
+// included last, Xlib defines macros clashing with Qt.
+#include <X11/Xlib.h>
+#include <X11/extensions/XTest.h>
+
+// Measures the time from DMenuClient::showMenu() until the service has
+// acknowledged ShowMenu, against a running deepin-menu service.
+//
+// With --click it measures the time from a synthesized click on the first
+// item until ItemInvoked arrives instead, which needs an X display.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption("n", "number of menus to show", "iterations", "200");
+    QCommandLineOption itemsOption("items", "number of items per menu", "items", "50");
+    QCommandLineOption legacyOption("legacy", "always send the menu as a JSON encoded string");
+    QCommandLineOption dockOption("dock", "show dock menus instead of desktop menus");
+    QCommandLineOption clickOption("click", "measure click to ItemInvoked instead of showing");
+    QCommandLineOption clickOffsetOption("click-offset", "where the first item is, relative to the menu position",
+                                         "dx,dy", "");
+    parser.addOptions({iterationsOption, itemsOption, legacyOption, dockOption, clickOption, clickOffsetOption});
+    parser.process(app);
+
+    const int iterations = parser.value(iterationsOption).toInt();
+    const int itemCount = parser.value(itemsOption).toInt();
+    const bool click = parser.isSet(clickOption);
+    const QPoint menuPos = parser.isSet(dockOption) ? QPoint(400, 600) : QPoint(100, 100);
+
+    // the first item of a desktop menu sits right below its position, the
+    // one of a dock menu with a single item right above the arrow.
+    QPoint clickOffset = parser.isSet(dockOption) ? QPoint(0, -30) : QPoint(30, 15);
+    const QStringList offset = parser.value(clickOffsetOption).split(',');
+    if (offset.size() == 2)
+        clickOffset = QPoint(offset.at(0).toInt(), offset.at(1).toInt());
+
+    Display *display = nullptr;
+    if (click) {
+        display = XOpenDisplay(nullptr);
+        if (!display) {
+            qWarning() << "--click needs an X display";
+            return 1;
+        }
+    }
+
+    DMenuBuilder menu;
+    for (int i = 0; i < (click ? 1 : itemCount); i++) {
+        if (i % 10 == 9)
+            menu.addSeparator();
+        else
+            menu.addItem(QString("item_%1").arg(i), QString("Menu Item %1").arg(i));
+    }
+
+    DMenuClient client;
+    client.setWireFormat(parser.isSet(legacyOption) ? DMenuClient::LegacyFormat : DMenuClient::AutoFormat);
+
+    QVector<qint64> samples;
+    samples.reserve(iterations);
+    QElapsedTimer timer;
+
+    auto showNext = [&] {
+        timer.start();
+        if (parser.isSet(dockOption))
+            client.showDockMenu(menu, menuPos, DMenuClient::ArrowBottom);
+        else
+            client.showMenu(menu, menuPos);
+    };
+
+    auto clickFirstItem = [&] {
+        const QPoint pos = menuPos + clickOffset;
+        XTestFakeMotionEvent(display, -1, pos.x(), pos.y(), CurrentTime);
+        XFlush(display);
+
+        timer.start();
+        XTestFakeButtonEvent(display, 1, True, CurrentTime);
+        XTestFakeButtonEvent(display, 1, False, CurrentTime);
+        XFlush(display);
+    };
+
+    QObject::connect(&client, &DMenuClient::error, [&] (const QString &message) {
+        qWarning() << "menu error:" << message;
+        app.exit(1);
+    });
+    auto report = [&] {
+        if (samples.isEmpty()) {
+            qWarning() << "no samples taken";
+            app.exit(1);
+            return;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&] (double p) {
+            return samples.at(qMin(samples.size() - 1, int(samples.size() * p))) / 1000000.0;
+        };
+        qint64 total = 0;
+        for (qint64 sample : samples)
+            total += sample;
+
+        if (click)
+            printf("iterations: %d, click to ItemInvoked\n", samples.size());
+        else
+            printf("iterations: %d, items: %d, format: %s\n", samples.size(), itemCount,
+                   parser.isSet(legacyOption) ? "legacy" : "auto");
+        printf("mean: %.3f ms, p50: %.3f ms, p90: %.3f ms, p99: %.3f ms, max: %.3f ms\n",
+               total / double(samples.size()) / 1000000.0,
+               percentile(0.5), percentile(0.9), percentile(0.99), samples.last() / 1000000.0);
+
+        app.quit();
+    };
+
+    QObject::connect(&client, &DMenuClient::menuShown, [&] {
+        if (click) {
+            // ShowMenu is acknowledged before the window is up.
+            QTimer::singleShot(300, clickFirstItem);
+            return;
+        }
+
+        samples << timer.nsecsElapsed();
+        if (samples.size() < iterations)
+            QTimer::singleShot(10, showNext);
+        else
+            report();
+    });
+    QObject::connect(&client, &DMenuClient::itemInvoked, [&] {
+        samples << timer.nsecsElapsed();
+    });
+    QObject::connect(&client, &DMenuClient::menuUnregistered, [&] {
+        if (!click)
+            return;
+
+        if (samples.size() < iterations)
+            QTimer::singleShot(10, showNext);
+        else
+            report();
+    });
+
+    // give the features query a head start so the first show already picks
+    // the right wire format.
+    QTimer::singleShot(100, showNext);
+
+    const int result = app.exec();
+
+    if (display)
+        XCloseDisplay(display);
+
+    return result;
+}
@@ -0,0 +1,9 @@
+QT       += core dbus
+QT       -= gui
+
+TARGET = deepin-menu-load-test
+TEMPLATE = app
+
+CONFIG += c++11 console
+
+SOURCES += main.cpp
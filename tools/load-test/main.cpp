@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <QDebug>
+
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+
+// Starts a private session bus and a deepin-menu instance on it, then has
+// a number of concurrent clients hammer the service while reporting
+// throughput, latency, event loop lag of the service and its memory use
+// once a second.
+//
+// Scenarios:
+//   register  RegisterMenu storms
+//   cycle     RegisterMenu, ShowMenu and UnregisterMenu in a row
+//   settext   SetItemText floods on one shown menu
+
+static const char *ServiceName = "com.deepin.menu";
+static const char *ManagerPath = "/com/deepin/menu";
+static const char *ManagerInterface = "com.deepin.menu.Manager";
+static const char *MenuInterface = "com.deepin.menu.Menu";
+
+static const int ItemCount = 20;
+
+static QString menuJson()
+{
+    QJsonArray items;
+    for (int i = 0; i < ItemCount; i++) {
+        QJsonObject item;
+        item["itemId"] = QString("item_%1").arg(i);
+        item["itemText"] = QString("Menu Item %1").arg(i);
+        item["isActive"] = true;
+        items.append(item);
+    }
+
+    QJsonObject content;
+    content["items"] = items;
+
+    QJsonObject params;
+    params["x"] = 100;
+    params["y"] = 100;
+    params["isDockMenu"] = false;
+    params["menuJsonContent"] = QString::fromUtf8(QJsonDocument(content).toJson(QJsonDocument::Compact));
+
+    return QString::fromUtf8(QJsonDocument(params).toJson(QJsonDocument::Compact));
+}
+
+static qint64 residentSetSize(qint64 pid)
+{
+    QFile status(QString("/proc/%1/status").arg(pid));
+    if (!status.open(QIODevice::ReadOnly))
+        return -1;
+
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith("VmRSS:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+
+    return -1;
+}
+
+static double percentile(QVector<qint64> samples, double p)
+{
+    if (samples.isEmpty())
+        return 0;
+
+    std::sort(samples.begin(), samples.end());
+    return samples.at(qMin(samples.size() - 1, int(samples.size() * p))) / 1000000.0;
+}
+
+class Statistics
+{
+public:
+    Statistics() : m_errors(0), m_intervalErrors(0) {}
+
+    void add(qint64 nsecs) { m_samples << nsecs; m_interval << nsecs; }
+    void addError() { m_errors++; m_intervalErrors++; }
+    void addLag(qint64 nsecs) { m_lag << nsecs; m_intervalLag << nsecs; }
+
+    // prints a line for the second gone by and starts a new one.
+    void report(qint64 elapsed, qint64 rss)
+    {
+        printf("%5.1fs  ops: %6d  errors: %4d  p50: %7.3f ms  p99: %7.3f ms  lag max: %7.3f ms  rss: %6lld kB\n",
+               elapsed / 1000.0, m_interval.size(), m_intervalErrors,
+               percentile(m_interval, 0.5), percentile(m_interval, 0.99),
+               m_intervalLag.isEmpty() ? 0 : *std::max_element(m_intervalLag.begin(), m_intervalLag.end()) / 1000000.0,
+               rss);
+        fflush(stdout);
+
+        m_interval.clear();
+        m_intervalLag.clear();
+        m_intervalErrors = 0;
+    }
+
+    void summary(qint64 elapsed) const
+    {
+        printf("\ntotal: %d ops in %.1f s, %.1f ops/s, %d errors\n", m_samples.size(), elapsed / 1000.0,
+               m_samples.size() * 1000.0 / qMax<qint64>(1, elapsed), m_errors);
+        printf("latency  p50: %.3f ms, p90: %.3f ms, p99: %.3f ms, max: %.3f ms\n",
+               percentile(m_samples, 0.5), percentile(m_samples, 0.9), percentile(m_samples, 0.99),
+               percentile(m_samples, 1));
+        printf("lag      p50: %.3f ms, p99: %.3f ms, max: %.3f ms\n",
+               percentile(m_lag, 0.5), percentile(m_lag, 0.99), percentile(m_lag, 1));
+    }
+
+private:
+    QVector<qint64> m_samples;
+    QVector<qint64> m_interval;
+    QVector<qint64> m_lag;
+    QVector<qint64> m_intervalLag;
+    int m_errors;
+    int m_intervalErrors;
+};
+
+// one client on its own bus connection, issuing its next operation as soon
+// as the previous one has been answered.
+class LoadClient : public QObject
+{
+public:
+    LoadClient(const QString &address, int id, const QString &scenario, Statistics *statistics)
+        : m_connection(QDBusConnection::connectToBus(address, QString("load-client-%1").arg(id)))
+        , m_id(id)
+        , m_scenario(scenario)
+        , m_statistics(statistics)
+        , m_counter(0)
+        , m_running(false)
+    {
+    }
+
+    bool isConnected() const { return m_connection.isConnected(); }
+    void setMenuPath(const QString &path) { m_menuPath = path; }
+
+    void start() { m_running = true; next(); }
+    void stop() { m_running = false; }
+
+private:
+    void next()
+    {
+        if (!m_running)
+            return;
+
+        m_timer.start();
+
+        if (m_scenario == "settext") {
+            QDBusMessage message = QDBusMessage::createMethodCall(ServiceName, m_menuPath, MenuInterface, "SetItemText");
+            message << QString("item_%1").arg(m_counter % ItemCount)
+                    << QString("Client %1 Text %2").arg(m_id).arg(m_counter);
+            m_counter++;
+            call(message, [this] (const QDBusMessage &) { done(); });
+            return;
+        }
+
+        call(QDBusMessage::createMethodCall(ServiceName, ManagerPath, ManagerInterface, "RegisterMenu"),
+             [this] (const QDBusMessage &reply) {
+            if (m_scenario == "register") {
+                done();
+                return;
+            }
+
+            const QString path = reply.arguments().value(0).value<QDBusObjectPath>().path();
+            QDBusMessage show = QDBusMessage::createMethodCall(ServiceName, path, MenuInterface, "ShowMenu");
+            show << menuJson();
+
+            call(show, [this, path] (const QDBusMessage &) {
+                QDBusMessage unregister = QDBusMessage::createMethodCall(ServiceName, ManagerPath, ManagerInterface, "UnregisterMenu");
+                unregister << path;
+                call(unregister, [this] (const QDBusMessage &) { done(); });
+            });
+        });
+    }
+
+    void call(const QDBusMessage &message, std::function<void (const QDBusMessage &)> onReply)
+    {
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(message), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] {
+            watcher->deleteLater();
+
+            if (watcher->isError()) {
+                m_statistics->addError();
+                next();
+                return;
+            }
+
+            onReply(watcher->reply());
+        });
+    }
+
+    void done()
+    {
+        m_statistics->add(m_timer.nsecsElapsed());
+        next();
+    }
+
+    QDBusConnection m_connection;
+    int m_id;
+    QString m_scenario;
+    Statistics *m_statistics;
+    QString m_menuPath;
+    int m_counter;
+    bool m_running;
+    QElapsedTimer m_timer;
+};
+
+static void stopProcess(QProcess *process)
+{
+    if (process->state() == QProcess::NotRunning)
+        return;
+
+    process->terminate();
+    if (!process->waitForFinished(2000))
+        process->kill();
+}
+
+// usage: deepin-menu-load-test [--scenario cycle|register|settext] [--clients n]
+//                              [--duration secs] [--server path] [--xvfb display]
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption scenarioOption("scenario", "cycle, register or settext", "scenario", "cycle");
+    QCommandLineOption clientsOption("clients", "number of concurrent clients", "n", "8");
+    QCommandLineOption durationOption("duration", "seconds to run", "secs", "10");
+    QCommandLineOption serverOption("server", "deepin-menu binary", "path", "deepin-menu");
+    QCommandLineOption xvfbOption("xvfb", "run the service on a new Xvfb display instead of offscreen", "display");
+    parser.addOptions({scenarioOption, clientsOption, durationOption, serverOption, xvfbOption});
+    parser.process(app);
+
+    const QString scenario = parser.value(scenarioOption);
+    if (scenario != "cycle" && scenario != "register" && scenario != "settext")
+        parser.showHelp(1);
+
+    QProcess bus;
+    QProcess xvfb;
+    QProcess server;
+    auto cleanUp = [&] {
+        stopProcess(&server);
+        stopProcess(&xvfb);
+        stopProcess(&bus);
+    };
+
+    bus.start("dbus-daemon", {"--session", "--nofork", "--print-address"});
+    if (!bus.waitForStarted() || !bus.waitForReadyRead(5000)) {
+        qWarning() << "can't start dbus-daemon";
+        cleanUp();
+        return 1;
+    }
+    const QString address = QString::fromLocal8Bit(bus.readLine()).trimmed();
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("DBUS_SESSION_BUS_ADDRESS", address);
+    if (parser.isSet(xvfbOption)) {
+        const QString display = parser.value(xvfbOption);
+        xvfb.start("Xvfb", {display, "-screen", "0", "1920x1080x24"});
+        if (!xvfb.waitForStarted()) {
+            qWarning() << "can't start Xvfb";
+            cleanUp();
+            return 1;
+        }
+        environment.insert("DISPLAY", display);
+    } else {
+        environment.insert("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    server.setProcessEnvironment(environment);
+    server.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    server.start(parser.value(serverOption), QStringList());
+    if (!server.waitForStarted()) {
+        qWarning() << "can't start" << parser.value(serverOption);
+        cleanUp();
+        return 1;
+    }
+
+    QDBusConnection probe = QDBusConnection::connectToBus(address, "load-probe");
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    while (!probe.interface()->isServiceRegistered(ServiceName)) {
+        if (waitTimer.elapsed() > 10000 || server.state() == QProcess::NotRunning) {
+            qWarning() << "deepin-menu didn't show up on the bus";
+            cleanUp();
+            return 1;
+        }
+        QThread::msleep(50);
+    }
+
+    Statistics statistics;
+    QVector<LoadClient *> clients;
+    for (int i = 0; i < parser.value(clientsOption).toInt(); i++) {
+        LoadClient *client = new LoadClient(address, i, scenario, &statistics);
+        if (!client->isConnected()) {
+            qWarning() << "client" << i << "can't connect to the bus";
+            cleanUp();
+            return 1;
+        }
+        clients << client;
+    }
+
+    // SetItemText floods all go to one menu, the service only keeps one.
+    if (scenario == "settext") {
+        QDBusMessage reply = probe.call(QDBusMessage::createMethodCall(ServiceName, ManagerPath, ManagerInterface, "RegisterMenu"));
+        const QString path = reply.arguments().value(0).value<QDBusObjectPath>().path();
+        QDBusMessage show = QDBusMessage::createMethodCall(ServiceName, path, MenuInterface, "ShowMenu");
+        show << menuJson();
+        probe.call(show);
+
+        for (LoadClient *client : clients)
+            client->setMenuPath(path);
+    }
+
+    printf("scenario: %s, clients: %d, bus: %s\n", qPrintable(scenario), clients.size(), qPrintable(address));
+
+    QElapsedTimer clock;
+    clock.start();
+
+    // event loop lag: a property read is answered on the service's main
+    // thread, its round trip grows with whatever keeps that thread busy.
+    QTimer lagTimer;
+    QObject::connect(&lagTimer, &QTimer::timeout, [&] {
+        QDBusMessage get = QDBusMessage::createMethodCall(ServiceName, ManagerPath, "org.freedesktop.DBus.Properties", "Get");
+        get << QString(ManagerInterface) << QString("Features");
+
+        QElapsedTimer *lag = new QElapsedTimer;
+        lag->start();
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(probe.asyncCall(get), &app);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished, [=, &statistics] {
+            statistics.addLag(lag->nsecsElapsed());
+            delete lag;
+            watcher->deleteLater();
+        });
+    });
+    lagTimer.start(100);
+
+    QTimer reportTimer;
+    QObject::connect(&reportTimer, &QTimer::timeout, [&] {
+        statistics.report(clock.elapsed(), residentSetSize(server.processId()));
+    });
+    reportTimer.start(1000);
+
+    QTimer::singleShot(parser.value(durationOption).toInt() * 1000, [&] {
+        for (LoadClient *client : clients)
+            client->stop();
+        lagTimer.stop();
+        reportTimer.stop();
+
+        statistics.summary(clock.elapsed());
+        app.quit();
+    });
+
+    QObject::connect(&server, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), [&] {
+        qWarning() << "deepin-menu exited during the test";
+        app.exit(1);
+    });
+
+    for (LoadClient *client : clients)
+        client->start();
+
+    const int result = app.exec();
+
+    server.disconnect();
+    qDeleteAll(clients);
+    cleanUp();
+
+    return result;
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMenu>
+#include <QAction>
+#include <QRegExp>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <cstdio>
+
+#include "ddesktopmenu.h"
+#include "dmenucontent.h"
+#include "dmenumodel.h"
+
+// Compares the engine dock and desktop menus share (DMenuModel and
+// DMenuContent) with the QMenu tree desktop menus used to be made of, on a
+// large nested menu: building it, laying out every (sub)menu once, painting
+// the root menu and how many objects it takes. Reports the fastest of all
+// rounds. Needs a display, run it with -platform offscreen otherwise.
+
+struct Timings {
+    qint64 build;
+    qint64 layout;
+    qint64 paint;
+    int objects;
+};
+
+static QJsonArray menuItems(const QString &prefix, int count, int subCount, int depth)
+{
+    QJsonArray items;
+    for (int i = 0; i < count; i++) {
+        const QString id = prefix + QString::number(i);
+
+        QJsonObject itemObj;
+        itemObj["itemId"] = id;
+        itemObj["itemText"] = "Item " + id;
+        itemObj["isActive"] = true;
+        itemObj["isCheckable"] = i % 5 == 0;
+        itemObj["checked"] = i % 10 == 0;
+        if (i % 3 == 0)
+            itemObj["itemExtra"] = "Ctrl+" + QString::number(i % 10);
+        if (depth > 0)
+            itemObj["itemSubMenu"] = QJsonObject{{"items", menuItems(id + ".", subCount, subCount, depth - 1)}};
+
+        items.append(itemObj);
+    }
+
+    return items;
+}
+
+// what DDesktopMenu did before it was moved onto the engine.
+static void addActions(QMenu *rootMenu, const QJsonArray &items)
+{
+    struct PendingMenu {
+        QMenu *menu;
+        QJsonArray items;
+    };
+
+    QVector<PendingMenu> pending;
+    pending.append(PendingMenu{rootMenu, items});
+
+    const QRegExp mnemonicRegExp("\\([^)]+\\)");
+    while (!pending.isEmpty()) {
+        const PendingMenu current = pending.takeLast();
+        QMenu *menu = current.menu;
+
+        for (const QJsonValue &item : current.items) {
+            const QJsonObject itemObj = item.toObject();
+            const QString itemText = itemObj["itemText"].toString().replace("_", QString()).replace(mnemonicRegExp, QString());
+            const QJsonArray subMenuItems = itemObj["itemSubMenu"].toObject()["items"].toArray();
+
+            QAction *action = nullptr;
+            if (subMenuItems.count()) {
+                QMenu *subMenu = new QMenu(menu);
+                action = menu->addMenu(subMenu);
+                pending.append(PendingMenu{subMenu, subMenuItems});
+            } else if (itemText.isEmpty()) {
+                menu->addSeparator();
+                continue;
+            } else {
+                action = new QAction(menu);
+                menu->addAction(action);
+            }
+
+            action->setText(itemText);
+            action->setShortcut(QKeySequence(itemObj["itemExtra"].toString()));
+            action->setEnabled(itemObj["isActive"].toBool());
+            action->setCheckable(itemObj["isCheckable"].toBool());
+            action->setChecked(itemObj["checked"].toBool());
+            action->setProperty("itemId", itemObj["itemId"].toString());
+
+            QObject::connect(action, &QAction::triggered, menu, [] {});
+        }
+    }
+}
+
+static Timings runQMenu(const QJsonArray &items)
+{
+    Timings timings;
+    QElapsedTimer timer;
+
+    timer.start();
+    QMenu *menu = new QMenu;
+    addActions(menu, items);
+    timings.build = timer.nsecsElapsed();
+
+    // a QMenu measures its actions whenever its size is asked for.
+    timer.restart();
+    for (QMenu *subMenu : menu->findChildren<QMenu *>())
+        subMenu->sizeHint();
+    menu->adjustSize();
+    timings.layout = timer.nsecsElapsed();
+
+    timer.restart();
+    menu->grab();
+    timings.paint = timer.nsecsElapsed();
+
+    timings.objects = menu->findChildren<QObject *>().size() + 1;
+    delete menu;
+
+    return timings;
+}
+
+static Timings runEngine(const QJsonArray &items)
+{
+    Timings timings;
+    QElapsedTimer timer;
+
+    timer.start();
+    QSharedPointer<DMenuModel> model(new DMenuModel);
+    model->build(items);
+    DDesktopMenu *menu = new DDesktopMenu;
+    timings.build = timer.nsecsElapsed();
+
+    // one submenu is reused for every row having one, like DDockMenu does.
+    timer.restart();
+    menu->setModel(model);
+    DDockMenu *subMenu = new DDockMenu(menu);
+    DMenuContent *subContent = subMenu->findChild<DMenuContent *>();
+    for (int item = 0; item < model->count(); item++) {
+        if (!model->hasSubMenu(item))
+            continue;
+
+        subContent->setModel(model.data(), model->childBegin(item), model->childCount(item));
+        subContent->contentWidth();
+        subContent->contentHeight();
+    }
+    timings.layout = timer.nsecsElapsed();
+
+    // the whole window like QMenu::grab(), background and border included.
+    timer.restart();
+    menu->grab();
+    timings.paint = timer.nsecsElapsed();
+
+    timings.objects = menu->findChildren<QObject *>().size() + 1;
+    delete menu;
+
+    return timings;
+}
+
+static Timings fastest(const QJsonArray &items, int rounds, Timings (*run)(const QJsonArray &))
+{
+    Timings best = run(items);
+    for (int round = 1; round < rounds; round++) {
+        const Timings timings = run(items);
+        best.build = qMin(best.build, timings.build);
+        best.layout = qMin(best.layout, timings.layout);
+        best.paint = qMin(best.paint, timings.paint);
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares the menu engine with QMenu on large nested menus.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("items", "Items of the root menu.", "count", "100"));
+    parser.addOption(QCommandLineOption("sub-items", "Items of every submenu.", "count", "19"));
+    parser.addOption(QCommandLineOption("depth", "Levels of submenus.", "depth", "1"));
+    parser.addOption(QCommandLineOption("rounds", "Rounds to take the fastest of.", "rounds", "10"));
+    parser.process(app);
+
+    const QJsonArray items = menuItems(QString(), parser.value("items").toInt(),
+                                       parser.value("sub-items").toInt(), parser.value("depth").toInt());
+    const int rounds = qMax(1, parser.value("rounds").toInt());
+
+    DMenuModel model;
+    model.build(items);
+    printf("%d items\n", model.count());
+
+    const Timings qmenu = fastest(items, rounds, runQMenu);
+    const Timings engine = fastest(items, rounds, runEngine);
+
+    printf("%-10s %12s %12s\n", "", "qmenu", "engine");
+    printf("%-10s %9.3f ms %9.3f ms\n", "build", qmenu.build / 1e6, engine.build / 1e6);
+    printf("%-10s %9.3f ms %9.3f ms\n", "layout", qmenu.layout / 1e6, engine.layout / 1e6);
+    printf("%-10s %9.3f ms %9.3f ms\n", "paint", qmenu.paint / 1e6, engine.paint / 1e6);
+    printf("%-10s %12d %12d\n", "objects", qmenu.objects, engine.objects);
+
+    return 0;
+}
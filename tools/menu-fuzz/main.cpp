@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+
+#include <cstdio>
+
+#include "dmenulimits.h"
+#include "dmenumodel.h"
+
+// Feeds randomly generated, mostly hostile ShowMenu payloads through the
+// same steps the service runs before showing a menu: the size check, JSON
+// parsing, the limit checks and building the model. Reports the slowest
+// payload of every shape, which should stay bounded however large the
+// generated input gets.
+
+enum Shape {
+    Wide,
+    Deep,
+    Bushy,
+    LongText,
+    Garbage,
+    ShapeCount
+};
+
+static const char *ShapeNames[] = { "wide", "deep", "bushy", "long-text", "garbage" };
+
+static int randomInt(int max)
+{
+    return qrand() % max;
+}
+
+static QString randomText(int length)
+{
+    QString text;
+    text.reserve(length);
+    for (int i = 0; i < length; i++)
+        text.append(QChar('a' + randomInt(26)));
+
+    return text;
+}
+
+static QJsonObject item(int id, const QString &text, const QJsonArray &subItems = QJsonArray())
+{
+    QJsonObject itemObj;
+    itemObj["itemId"] = QString::number(id);
+    itemObj["itemText"] = text;
+    itemObj["isActive"] = true;
+    if (!subItems.isEmpty())
+        itemObj["itemSubMenu"] = QJsonObject{{"items", subItems}};
+
+    return itemObj;
+}
+
+static QJsonArray bushy(int depth, int *id)
+{
+    QJsonArray items;
+    const int count = 1 + randomInt(12);
+    for (int i = 0; i < count; i++) {
+        QJsonArray subItems;
+        if (depth > 0 && randomInt(3) == 0)
+            subItems = bushy(depth - 1, id);
+        items.append(item((*id)++, randomText(1 + randomInt(24)), subItems));
+    }
+
+    return items;
+}
+
+static QJsonArray generate(Shape shape, int scale)
+{
+    QJsonArray items;
+    int id = 0;
+
+    switch (shape) {
+    case Wide:
+        for (int i = 0; i < scale * 1000; i++)
+            items.append(item(id++, randomText(8)));
+        break;
+    case Deep:
+        // built inside out, Qt refuses documents nested over 1024 levels.
+        items.append(item(id++, "leaf"));
+        for (int i = 0; i < qMin(scale * 20, 500); i++)
+            items = QJsonArray{item(id++, randomText(8), items)};
+        break;
+    case Bushy:
+        items = bushy(2 + scale, &id);
+        break;
+    case LongText:
+        for (int i = 0; i < 1 + randomInt(8); i++)
+            items.append(item(id++, randomText(scale * 1000 + randomInt(1000))));
+        break;
+    case Garbage:
+        for (int i = 0; i < scale * 100; i++) {
+            QJsonObject itemObj;
+            itemObj["itemId"] = randomInt(2) ? QJsonValue(i) : QJsonValue(QJsonArray{i});
+            itemObj["itemText"] = randomInt(2) ? QJsonValue(true) : QJsonValue(randomText(4));
+            itemObj["itemSubMenu"] = randomInt(2) ? QJsonValue(QJsonArray{i}) : QJsonValue(QJsonObject{{"items", i}});
+            items.append(itemObj);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return items;
+}
+
+struct Result {
+    int accepted;
+    int rejected;
+    qint64 worst;
+    int worstBytes;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Times the service's handling of hostile menu payloads.");
+    parser.addHelpOption();
+    QCommandLineOption roundsOption("rounds", "payloads generated per shape.", "count", "50");
+    QCommandLineOption scaleOption("scale", "largest payload scale.", "scale", "20");
+    QCommandLineOption seedOption("seed", "random seed.", "seed", "1");
+    parser.addOptions({roundsOption, scaleOption, seedOption});
+    parser.process(app);
+
+    const int rounds = parser.value(roundsOption).toInt();
+    const int scale = qMax(1, parser.value(scaleOption).toInt());
+    qsrand(parser.value(seedOption).toUInt());
+
+    const DMenuLimits &limits = DMenuLimits::instance();
+    printf("limits: %d bytes, %d items, %d levels, %d characters\n",
+           limits.maxBytes(), limits.maxItems(), limits.maxDepth(), limits.maxTextLength());
+
+    QVector<Result> results(ShapeCount, Result{0, 0, 0, 0});
+    for (int round = 0; round < rounds; round++) {
+        for (int shape = 0; shape < ShapeCount; shape++) {
+            QJsonObject menuObj;
+            menuObj["x"] = 0;
+            menuObj["y"] = 0;
+            menuObj["isDockMenu"] = true;
+            menuObj["menuJsonContent"] = QJsonObject{{"items", generate(Shape(shape), 1 + randomInt(scale))}};
+            const QByteArray bytes = QJsonDocument(menuObj).toJson(QJsonDocument::Compact);
+
+            QElapsedTimer timer;
+            timer.start();
+
+            QString error;
+            bool accepted = limits.checkSize(bytes.size(), &error);
+            if (accepted) {
+                const QJsonObject jsonObj = QJsonDocument::fromJson(bytes).object();
+                const QJsonArray items = jsonObj["menuJsonContent"].toObject()["items"].toArray();
+
+                accepted = limits.checkItems(items, &error);
+                if (accepted) {
+                    DMenuModel model;
+                    model.build(items);
+                }
+            }
+
+            const qint64 elapsed = timer.nsecsElapsed();
+
+            Result &result = results[shape];
+            if (accepted)
+                result.accepted++;
+            else
+                result.rejected++;
+            if (elapsed > result.worst) {
+                result.worst = elapsed;
+                result.worstBytes = bytes.size();
+            }
+        }
+    }
+
+    printf("%-10s %9s %9s %12s %12s\n", "shape", "accepted", "rejected", "worst (ms)", "its bytes");
+    for (int shape = 0; shape < ShapeCount; shape++) {
+        const Result &result = results.at(shape);
+        printf("%-10s %9d %9d %12.3f %12d\n", ShapeNames[shape], result.accepted, result.rejected,
+               result.worst / 1e6, result.worstBytes);
+    }
+
+    return 0;
+}
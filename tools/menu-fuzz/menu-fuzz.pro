@@ -0,0 +1,13 @@
+QT       += core
+QT       -= gui
+
+TARGET = deepin-menu-fuzz
+TEMPLATE = app
+
+CONFIG += c++11 console
+
+INCLUDEPATH += $$PWD/../../src
+
+SOURCES += main.cpp \
+    $$PWD/../../src/dmenulimits.cpp \
+    $$PWD/../../src/dmenumodel.cpp
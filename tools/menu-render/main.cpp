@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFont>
+#include <QFontInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <cstdio>
+#include <functional>
+#include <limits>
+
+#include "ddockmenu.h"
+#include "dmenucontent.h"
+#include "dmenumodel.h"
+
+// Renders menus offscreen and compares them with golden images, timing every
+// rendering path meanwhile. The menu contents are rendered through
+// DMenuContent::renderToImage at every device pixel ratio, the whole window,
+// with the DArrowRectangle background, border and arrow, once through
+// QWidget::grab at the ratio of the screen; the drop shadow is left out of
+// both. Goldens are rendered with Noto Sans, write them with --update on a
+// machine having it. Run it with -platform offscreen to keep it headless.
+//
+// Exits with 1 if an image is missing or differs, with 2 if Noto Sans isn't
+// installed and the images can't be compared at all.
+//
+// usage: deepin-menu-render [--update] [--rounds N] [--tolerance T] <golden dir>
+
+struct Scenario {
+    const char *name;
+    DDockMenu::Appearance appearance;
+    QJsonArray items;
+    // sets the menu up for the given round, returns the hovered row.
+    std::function<int (DDockMenu *menu, int round)> prepare;
+};
+
+static QJsonObject item(const QString &id, const QString &text, const QString &extra = QString())
+{
+    QJsonObject itemObj;
+    itemObj["itemId"] = id;
+    itemObj["itemText"] = text;
+    itemObj["itemExtra"] = extra;
+    itemObj["isActive"] = true;
+
+    return itemObj;
+}
+
+static QJsonArray commonItems()
+{
+    QJsonObject checkable = item("wrap", "Word Wrap");
+    checkable["isCheckable"] = true;
+    checkable["checked"] = true;
+
+    QJsonObject disabled = item("paste", "Paste", "Ctrl+V");
+    disabled["isActive"] = false;
+
+    QJsonObject subMenu = item("sort", "Sort By");
+    subMenu["itemSubMenu"] = QJsonObject{{"items", QJsonArray{item("name", "Name"), item("size", "Size")}}};
+
+    return QJsonArray{item("open", "Open", "Ctrl+O"), item("copy", "Copy", "Ctrl+C"), disabled,
+                      item("separator", QString()), checkable, subMenu};
+}
+
+static QJsonArray longTextItems()
+{
+    QJsonArray items;
+    for (int i = 0; i < 8; i++)
+        items.append(item(QString::number(i), QString("Open With %1 ").arg(i).repeated(20), "Ctrl+" + QString::number(i)));
+
+    return items;
+}
+
+static QVector<Scenario> scenarios()
+{
+    auto idle = [](DDockMenu *, int) { return -1; };
+
+    return QVector<Scenario> {
+        {"dock", DDockMenu::DockAppearance, commonItems(), idle},
+        {"desktop", DDockMenu::DesktopAppearance, commonItems(), idle},
+        // the hovered row moves every round, the golden is the first one.
+        {"hover-change", DDockMenu::DockAppearance, commonItems(), [](DDockMenu *, int round) {
+            return round % 6;
+        }},
+        // items toggled through the same calls SetItem* end up in.
+        {"state-override", DDockMenu::DesktopAppearance, commonItems(), [](DDockMenu *menu, int round) {
+            menu->setItemActivity("copy", round % 2 != 0);
+            menu->setItemChecked("wrap", round % 2 != 0);
+            return 1;
+        }},
+        // every row is too wide and elided.
+        {"long-text", DDockMenu::DockAppearance, longTextItems(), idle},
+    };
+}
+
+static bool sameImage(const QImage &a, const QImage &b, int tolerance)
+{
+    if (a.size() != b.size())
+        return false;
+
+    const QImage first = a.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const QImage second = b.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < first.height(); y++) {
+        const QRgb *firstLine = reinterpret_cast<const QRgb *>(first.constScanLine(y));
+        const QRgb *secondLine = reinterpret_cast<const QRgb *>(second.constScanLine(y));
+        for (int x = 0; x < first.width(); x++) {
+            const QRgb p = firstLine[x];
+            const QRgb q = secondLine[x];
+            if (qAbs(qRed(p) - qRed(q)) > tolerance || qAbs(qGreen(p) - qGreen(q)) > tolerance
+                    || qAbs(qBlue(p) - qBlue(q)) > tolerance || qAbs(qAlpha(p) - qAlpha(q)) > tolerance)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders menus offscreen and checks them against golden images.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("update", "Write the golden images instead of checking them."));
+    parser.addOption(QCommandLineOption("rounds", "Rounds to time every path with.", "rounds", "100"));
+    parser.addOption(QCommandLineOption("tolerance", "Largest channel difference still matching.", "value", "0"));
+    parser.addPositionalArgument("dir", "Directory of the golden images.");
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    const QDir dir(parser.positionalArguments().first());
+    const bool update = parser.isSet("update");
+    const int rounds = qMax(1, parser.value("rounds").toInt());
+    const int tolerance = parser.value("tolerance").toInt();
+
+    if (update && !dir.mkpath("."))
+        qFatal("can't create %s", qPrintable(dir.path()));
+
+    // fixed, so the goldens don't follow the desktop settings.
+    QFont font("Noto Sans");
+    font.setPixelSize(13);
+    app.setFont(font);
+
+    // a fallback font shifts every glyph, don't report that as differences.
+    if (QFontInfo(font).family() != font.family()) {
+        fprintf(stderr, "Noto Sans isn't installed (fonts-noto-core), the menus can't be rendered "
+                        "the way the golden images were.\n");
+        return 2;
+    }
+
+    if (!update && dir.entryList({"*.png"}, QDir::Files).isEmpty()) {
+        fprintf(stderr, "no golden images in %s, write them with --update on a machine having "
+                        "Noto Sans and commit them.\n", qPrintable(dir.path()));
+        return 1;
+    }
+
+    const qreal ratios[] = { 1, 1.25, 2 };
+    int failures = 0;
+
+    auto check = [&](const QImage &image, const QString &name) {
+        const QString file = dir.filePath(name + ".png");
+        if (update)
+            return image.save(file) ? QString("written") : QString("not written");
+        if (!QFile::exists(file)) {
+            failures++;
+            return QString("missing");
+        }
+        if (sameImage(image, QImage(file), tolerance))
+            return QString("ok");
+
+        // next to the golden, to look at the two side by side.
+        image.save(dir.filePath(name + ".actual.png"));
+        failures++;
+        return QString("differs");
+    };
+
+    printf("%-16s %6s %12s  %s\n", "path", "ratio", "render", "golden");
+    for (const Scenario &scenario : scenarios()) {
+        {
+            DDockMenu menu;
+            menu.setAppearance(scenario.appearance);
+            menu.setItems(scenario.items);
+            scenario.prepare(&menu, 0);
+
+            QElapsedTimer timer;
+            timer.start();
+            const QImage image = menu.grab().toImage();
+            const qint64 elapsed = timer.nsecsElapsed();
+
+            printf("%-16s %6s %9.3f ms  %s\n", scenario.name, "window", elapsed / 1e6,
+                   qPrintable(check(image, QString("%1.window").arg(scenario.name))));
+        }
+
+        for (const qreal ratio : ratios) {
+            DDockMenu menu;
+            menu.setAppearance(scenario.appearance);
+            menu.setItems(scenario.items);
+            DMenuContent *content = menu.findChild<DMenuContent *>();
+
+            const QImage image = content->renderToImage(ratio, scenario.prepare(&menu, 0));
+
+            qint64 best = std::numeric_limits<qint64>::max();
+            QElapsedTimer timer;
+            for (int round = 1; round <= rounds; round++) {
+                const int hoveredRow = scenario.prepare(&menu, round);
+
+                timer.start();
+                content->renderToImage(ratio, hoveredRow);
+                best = qMin(best, timer.nsecsElapsed());
+            }
+
+            const QString result = check(image, QString("%1@%2x").arg(scenario.name).arg(ratio));
+            printf("%-16s %5.2fx %9.3f ms  %s\n", scenario.name, ratio, best / 1e6, qPrintable(result));
+        }
+    }
+
+    return failures > 0 ? 1 : 0;
+}
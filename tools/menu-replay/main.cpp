@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QTimer>
+#include <QVector>
+#include <QDebug>
+
+#include <algorithm>
+#include <cstdio>
+
+// Replays a recording made with DEEPIN_MENU_RECORD against a running
+// deepin-menu service and reports how long the service took to answer
+// each kind of call.
+//
+// Every recorded ShowMenu registers a fresh menu first, later calls to the
+// recorded menu path go to the menu registered for it.
+
+static const char *ServiceName = "com.deepin.menu";
+static const char *ManagerPath = "/com/deepin/menu";
+static const char *ManagerInterface = "com.deepin.menu.Manager";
+static const char *MenuInterface = "com.deepin.menu.Menu";
+
+struct Call {
+    qint64 time;
+    QString path;
+    QString method;
+    QVariantList args;
+};
+
+class Replayer : public QObject
+{
+public:
+    Replayer(const QDBusConnection &connection, const QVector<Call> &calls, double speed)
+        : m_connection(connection)
+        , m_calls(calls)
+        , m_speed(speed)
+        , m_next(0)
+        , m_inFlight(0)
+        , m_errors(0)
+    {
+        m_timer.setSingleShot(true);
+        connect(&m_timer, &QTimer::timeout, this, &Replayer::dispatch);
+    }
+
+    void start()
+    {
+        m_clock.start();
+        dispatch();
+    }
+
+private:
+    // sends every call which is due, then sleeps until the next one is.
+    void dispatch()
+    {
+        while (m_next < m_calls.size()) {
+            const Call &call = m_calls.at(m_next);
+            const qint64 due = m_speed > 0 ? qint64(call.time / m_speed) : 0;
+            const qint64 now = m_clock.nsecsElapsed() / 1000;
+
+            if (due > now) {
+                m_timer.start(int((due - now + 999) / 1000));
+                return;
+            }
+
+            m_next++;
+            send(call);
+        }
+
+        finishIfDone();
+    }
+
+    void send(const Call &call)
+    {
+        if (call.method == "ShowMenu") {
+            showMenu(call);
+            return;
+        }
+
+        const QString path = m_paths.value(call.path);
+        if (path.isEmpty()) {
+            // the menu is still being registered.
+            m_pending[call.path] << call;
+            return;
+        }
+
+        QDBusMessage message = QDBusMessage::createMethodCall(ServiceName, path, MenuInterface, call.method);
+        message.setArguments(call.args);
+        track(call.method, m_connection.asyncCall(message));
+    }
+
+    void showMenu(const Call &call)
+    {
+        m_paths.remove(call.path);
+
+        QElapsedTimer *timer = new QElapsedTimer;
+        timer->start();
+
+        QDBusMessage registerMessage = QDBusMessage::createMethodCall(ServiceName, ManagerPath, ManagerInterface, "RegisterMenu");
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(registerMessage), this);
+        m_inFlight++;
+
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] {
+            watcher->deleteLater();
+            m_inFlight--;
+
+            QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+            if (reply.isError()) {
+                qWarning() << "RegisterMenu failed:" << reply.error().message();
+                m_errors++;
+                delete timer;
+                finishIfDone();
+                return;
+            }
+            m_samples["RegisterMenu"] << timer->nsecsElapsed();
+
+            const QString path = reply.value().path();
+            m_paths[call.path] = path;
+
+            QDBusMessage showMessage = QDBusMessage::createMethodCall(ServiceName, path, MenuInterface, "ShowMenu");
+            showMessage.setArguments(call.args);
+            track("ShowMenu", m_connection.asyncCall(showMessage), timer);
+
+            for (const Call &pending : m_pending.take(call.path))
+                send(pending);
+        });
+    }
+
+    // records the time until reply, measured from timer if given.
+    void track(const QString &method, const QDBusPendingCall &pendingCall, QElapsedTimer *timer = nullptr)
+    {
+        if (!timer) {
+            timer = new QElapsedTimer;
+            timer->start();
+        }
+
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pendingCall, this);
+        m_inFlight++;
+
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] {
+            watcher->deleteLater();
+            m_inFlight--;
+
+            if (watcher->isError()) {
+                qWarning() << method << "failed:" << watcher->error().message();
+                m_errors++;
+            } else {
+                m_samples[method] << timer->nsecsElapsed();
+            }
+            delete timer;
+
+            finishIfDone();
+        });
+    }
+
+    void finishIfDone()
+    {
+        if (m_next < m_calls.size() || m_inFlight > 0)
+            return;
+
+        printf("%d calls replayed in %.3f s, %d errors\n", m_calls.size(),
+               m_clock.nsecsElapsed() / 1000000000.0, m_errors);
+
+        for (auto it = m_samples.begin(); it != m_samples.end(); ++it) {
+            QVector<qint64> &samples = it.value();
+            std::sort(samples.begin(), samples.end());
+
+            auto percentile = [&] (double p) {
+                return samples.at(qMin(samples.size() - 1, int(samples.size() * p))) / 1000000.0;
+            };
+            qint64 total = 0;
+            for (qint64 sample : samples)
+                total += sample;
+
+            printf("%-16s n: %5d, mean: %.3f ms, p50: %.3f ms, p90: %.3f ms, p99: %.3f ms, max: %.3f ms\n",
+                   qPrintable(it.key()), samples.size(), total / double(samples.size()) / 1000000.0,
+                   percentile(0.5), percentile(0.9), percentile(0.99), samples.last() / 1000000.0);
+        }
+
+        qApp->exit(m_errors ? 1 : 0);
+    }
+
+    QDBusConnection m_connection;
+    QVector<Call> m_calls;
+    double m_speed;
+
+    int m_next;
+    int m_inFlight;
+    int m_errors;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+
+    // recorded menu path -> path of the menu registered for it.
+    QHash<QString, QString> m_paths;
+    QHash<QString, QVector<Call>> m_pending;
+    QMap<QString, QVector<qint64>> m_samples;
+};
+
+static QVector<Call> loadRecording(const QString &fileName)
+{
+    QVector<Call> calls;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "can't open" << fileName << file.errorString();
+        return calls;
+    }
+
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+
+        const QJsonObject callObj = QJsonDocument::fromJson(line).object();
+        const QString method = callObj["method"].toString();
+        const QJsonArray args = callObj["args"].toArray();
+
+        QVariantList arguments;
+        if (method == "ShowMenu" && args.size() == 1) {
+            arguments << args.at(0).toString();
+        } else if (method == "SetItemText" && args.size() == 2) {
+            arguments << args.at(0).toString() << args.at(1).toString();
+        } else if ((method == "SetItemActivity" || method == "SetItemChecked") && args.size() == 2) {
+            arguments << args.at(0).toString() << args.at(1).toBool();
+        } else {
+            qWarning() << "skipping unknown call" << line;
+            continue;
+        }
+
+        calls << Call{qint64(callObj["t"].toDouble()), callObj["path"].toString(), method, arguments};
+    }
+
+    return calls;
+}
+
+// usage: deepin-menu-replay [--speed factor] [--address bus-address] recording
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption speedOption("speed", "replay speed, 1 is the original pace, 0 sends calls as fast as possible", "factor", "1");
+    QCommandLineOption addressOption("address", "address of the bus the service runs on, instead of the session bus", "address");
+    parser.addOptions({speedOption, addressOption});
+    parser.addPositionalArgument("recording", "file recorded with DEEPIN_MENU_RECORD");
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    const QVector<Call> calls = loadRecording(parser.positionalArguments().first());
+    if (calls.isEmpty())
+        return 1;
+
+    QDBusConnection connection = parser.isSet(addressOption)
+            ? QDBusConnection::connectToBus(parser.value(addressOption), "deepin-menu-replay")
+            : QDBusConnection::sessionBus();
+    if (!connection.isConnected()) {
+        qWarning() << "can't connect to the bus:" << connection.lastError().message();
+        return 1;
+    }
+
+    Replayer replayer(connection, calls, parser.value(speedOption).toDouble());
+    QTimer::singleShot(0, &replayer, &Replayer::start);
+
+    return app.exec();
+}
@@ -0,0 +1,9 @@
+QT       += core dbus
+QT       -= gui
+
+TARGET = deepin-menu-replay
+TEMPLATE = app
+
+CONFIG += c++11 console
+
+SOURCES += main.cpp
@@ -0,0 +1,67 @@
+#! /usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# Copyright (C) 2015 Deepin Technology Co., Ltd.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# Times building, looking up and serializing a 2000 item deepin_menu tree,
+# run it against different revisions of deepin_menu to compare them.
+#
+# usage: menu_model_benchmark.py [rounds]
+
+from __future__ import print_function
+
+import os
+import sys
+import timeit
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "deepin_menu"))
+
+from menu import Menu, MenuItem
+
+TOP_LEVEL_ITEMS = 100
+SUB_MENU_ITEMS = 19
+
+def buildTree():
+    root = Menu(is_root=False)
+    for i in range(TOP_LEVEL_ITEMS):
+        item = MenuItem("id_%d" % i, "Item %d" % i)
+        subMenu = Menu(is_root=False)
+        for j in range(SUB_MENU_ITEMS):
+            subMenu.addMenuItem(MenuItem("id_%d_%d" % (i, j), "Item %d.%d" % (i, j)))
+        item.setSubMenu(subMenu)
+        root.addMenuItem(item)
+    return root
+
+def main():
+    rounds = int(sys.argv[1]) if len(sys.argv) > 1 else 20
+
+    root = buildTree()
+    ids = ["id_%d_%d" % (i, j) for i in range(TOP_LEVEL_ITEMS) for j in range(SUB_MENU_ITEMS)]
+
+    def lookup():
+        for id in ids:
+            root.getItemById(id)
+
+    counter = [0]
+    def updateAndSerialize():
+        counter[0] += 1
+        root.setItemText(ids[counter[0] % len(ids)], "Text %d" % counter[0])
+        str(root)
+
+    def report(name, func, number):
+        seconds = min(timeit.repeat(func, number=number, repeat=rounds)) / number
+        print("%-24s %10.3f ms" % (name, seconds * 1000))
+
+    print("%d items" % (TOP_LEVEL_ITEMS * (SUB_MENU_ITEMS + 1)))
+    report("build", buildTree, 1)
+    report("getItemById x %d" % len(ids), lookup, 1)
+    report("serialize (unchanged)", lambda: str(root), 10)
+    report("setItemText + serialize", updateAndSerialize, 10)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,83 @@
+#! /usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# Copyright (C) 2015 Deepin Technology Co., Ltd.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# Measures the time between asking deepin_menu to show a menu and the
+# ShowMenu call leaving the process, against a running deepin-menu service.
+#
+# usage: menu_show_latency.py [--sync] [--warm] [iterations]
+
+from __future__ import print_function
+
+import os
+import sys
+import json
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "deepin_menu"))
+
+from PyQt5.QtCore import QCoreApplication, QTimer
+from PyQt5.QtDBus import QDBusReply
+
+from menu import Menu, objectPathString
+from DBusInterfaces import MenuObjectInterface, sharedManagerInterface
+
+class Probe(object):
+    def __init__(self, iterations, sync, warm):
+        self.iterations = iterations
+        self.sync = sync
+        self.samples = []
+        self.clickTime = 0
+        self.menu = Menu([("id_%d" % i, "Item %d" % i) for i in range(20)], keepWarm=warm)
+
+        showMenu = MenuObjectInterface.showMenu
+        def timedShowMenu(iface, jsonContent):
+            self.samples.append(time.time() - self.clickTime)
+            QTimer.singleShot(5, self.next)
+            return showMenu(iface, jsonContent)
+        MenuObjectInterface.showMenu = timedShowMenu
+
+    def showSync(self):
+        # what deepin_menu used to do: a blocking RegisterMenu and a fresh
+        # proxy for every show.
+        reply = QDBusReply(sharedManagerInterface().registerMenu())
+        iface = MenuObjectInterface(objectPathString(reply.value()))
+        iface.showMenu(json.dumps({"x": 0, "y": 0, "isDockMenu": False,
+                                   "menuJsonContent": str(self.menu)}))
+
+    def next(self):
+        if len(self.samples) >= self.iterations:
+            self.report()
+            QCoreApplication.quit()
+            return
+
+        self.clickTime = time.time()
+        if self.sync:
+            self.showSync()
+        else:
+            self.menu.showRectMenu(0, 0)
+
+    def report(self):
+        samples = sorted(self.samples)
+        def percentile(p):
+            return samples[min(len(samples) - 1, int(len(samples) * p))] * 1000
+        print("iterations: %d" % len(samples))
+        print("mean: %.3f ms" % (sum(samples) / len(samples) * 1000))
+        print("p50: %.3f ms, p90: %.3f ms, p99: %.3f ms, max: %.3f ms" %
+              (percentile(0.5), percentile(0.9), percentile(0.99), samples[-1] * 1000))
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    counts = [int(a) for a in args if not a.startswith("--")]
+    iterations = counts[0] if counts else 1000
+
+    app = QCoreApplication([])
+    probe = Probe(iterations, "--sync" in args, "--warm" in args)
+    QTimer.singleShot(0, probe.next)
+    sys.exit(app.exec_())
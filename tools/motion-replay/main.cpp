@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2015 ~ 2018 Deepin Technology Co., Ltd.
+ *
+ * Author:     Hualet Wang <mr.asianwang@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMouseEvent>
+
+#include <cstdio>
+
+#include "ddockmenu.h"
+
+// Replays synthetic pointer moves over a dock menu through the path live
+// menus take, DDockMenu::mouseMoveEvent and its per-frame coalescing, and
+// reports how many of them were hit-tested and what a move costs. Moves
+// are sent in bursts, the event loop runs between them like it does
+// between the batches of events Qt reads from X. Needs a display, run it
+// with -platform offscreen otherwise.
+//
+// usage: deepin-menu-motion-replay [--events N] [--burst N] [--rows N]
+
+static QJsonArray menuItems(int count)
+{
+    QJsonArray items;
+    for (int i = 0; i < count; i++) {
+        QJsonObject itemObj;
+        itemObj["itemId"] = QString::number(i);
+        itemObj["itemText"] = QString("Item %1").arg(i);
+        itemObj["isActive"] = true;
+        items.append(itemObj);
+    }
+
+    return items;
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays synthetic pointer moves over a dock menu.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("events", "Moves to replay.", "count", "100000"));
+    parser.addOption(QCommandLineOption("burst", "Moves sent between two runs of the event loop.", "count", "8"));
+    parser.addOption(QCommandLineOption("rows", "Rows of the menu.", "count", "20"));
+    parser.process(app);
+
+    const int events = qMax(1, parser.value("events").toInt());
+    const int burst = qMax(1, parser.value("burst").toInt());
+
+    DDockMenu menu;
+    menu.setItems(menuItems(qMax(1, parser.value("rows").toInt())));
+
+    // moves sweep down and up the menu, crossing a row every few events.
+    const QRect area = menu.rect();
+    auto positionAt = [&] (int i) {
+        const int span = qMax(1, area.height() - 1);
+        const int step = i % (2 * span);
+        return QPoint(area.center().x() + i % 7, step < span ? step : 2 * span - step);
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < events; i++) {
+        const QPoint pos = positionAt(i);
+        QMouseEvent event(QEvent::MouseMove, pos, menu.mapToGlobal(pos), Qt::NoButton, Qt::NoButton, Qt::NoModifier);
+        QApplication::sendEvent(&menu, &event);
+
+        if ((i + 1) % burst == 0)
+            app.processEvents();
+    }
+    app.processEvents();
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    printf("%d moves in %.3f ms, %.1f ns/move\n", events, elapsed / 1e6, double(elapsed) / events);
+    printf("received: %llu, hit-tested: %llu\n",
+           static_cast<unsigned long long>(menu.motionEventsReceived()),
+           static_cast<unsigned long long>(menu.motionEventsProcessed()));
+
+    return 0;
+}
@@ -0,0 +1,36 @@
+QT       += core gui widgets dtkwidget x11extras
+
+# dscreentopology.cpp reads the native screen geometry.
+greaterThan(QT_MINOR_VERSION, 7): QT += gui-private
+else: QT += platformsupport-private
+
+TARGET = deepin-menu-motion-replay
+TEMPLATE = app
+
+CONFIG += c++11 console link_pkgconfig
+PKGCONFIG += xcb
+
+INCLUDEPATH += $$PWD/../../src
+
+SOURCES += main.cpp \
+    $$PWD/../../src/dabstractmenu.cpp \
+    $$PWD/../../src/ddockmenu.cpp \
+    $$PWD/../../src/dmenucontent.cpp \
+    $$PWD/../../src/dmenumodel.cpp \
+    $$PWD/../../src/dscreentopology.cpp \
+    $$PWD/../../src/drendertier.cpp \
+    $$PWD/../../src/ddecorationatlas.cpp \
+    $$PWD/../../src/utils.cpp
+
+HEADERS += \
+    $$PWD/../../src/dabstractmenu.h \
+    $$PWD/../../src/ddockmenu.h \
+    $$PWD/../../src/dmenucontent.h \
+    $$PWD/../../src/dmenumodel.h \
+    $$PWD/../../src/dscreentopology.h \
+    $$PWD/../../src/drendertier.h \
+    $$PWD/../../src/ddecorationatlas.h \
+    $$PWD/../../src/utils.h
+
+RESOURCES += \
+    ../../images.qrc
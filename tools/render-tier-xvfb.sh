@@ -0,0 +1,36 @@
+#!/bin/sh
+
+# Compares dock menu frame times of the full and the low cost render tier
+# under Xvfb, on a private session bus.
+#
+# usage: render-tier-xvfb.sh <deepin-menu> <deepin-menu-client-latency> [iterations]
+
+set -e
+
+SERVER=${1:?deepin-menu binary}
+CLIENT=${2:?deepin-menu-client-latency binary}
+ITERATIONS=${3:-100}
+DISPLAY_NUMBER=${DISPLAY_NUMBER:-97}
+
+LOG_DIR=$(mktemp -d)
+
+Xvfb ":$DISPLAY_NUMBER" -screen 0 1920x1080x24 >/dev/null 2>&1 &
+XVFB_PID=$!
+trap 'kill $XVFB_PID 2>/dev/null; rm -rf "$LOG_DIR"' EXIT
+sleep 1
+
+for TIER in full low; do
+    DISPLAY=":$DISPLAY_NUMBER" DEEPIN_MENU_RENDER_TIER=$TIER \
+        QT_LOGGING_RULES="deepin.menu.frames.debug=true" dbus-run-session -- sh -c "
+        \"$SERVER\" >\"$LOG_DIR/$TIER.log\" 2>&1 &
+        SERVER_PID=\$!
+        sleep 1
+        \"$CLIENT\" --dock -n $ITERATIONS
+        kill \$SERVER_PID
+        wait \$SERVER_PID || true
+    "
+
+    # menus log the running average as they go away, take the latest.
+    FRAME_TIME=$(grep -o 'average frame time (us): [0-9]*' "$LOG_DIR/$TIER.log" | tail -n 1 | grep -o '[0-9]*$')
+    echo "$TIER tier: average frame time ${FRAME_TIME:-?} us"
+done